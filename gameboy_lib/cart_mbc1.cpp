@@ -1,16 +1,14 @@
 #include "cart_mbc1.hpp"
-#include "debug.hpp"
 #include "bits.hpp"
-#include <algorithm>
 
-gb::cart_mbc1::cart_mbc1(rom rom) :
+gb::cart_mbc1::cart_mbc1(rom rom, const std::string &save_path) :
 	_rom(rom),
 	_ram_enabled(false),
 	_rom_bank_low(0),
 	_ram_rom_bank(0),
-	_ram_mode(false)
+	_ram_mode(false),
+	_ram(_rom.ram_size(), save_path)
 {
-	std::fill(_ram.begin(), _ram.end(), 0);
 }
 
 bool gb::cart_mbc1::read8(uint16_t addr, uint8_t &value) const
@@ -22,35 +20,12 @@ bool gb::cart_mbc1::read8(uint16_t addr, uint8_t &value) const
 	}
 	else if (0x4000 <= addr && addr < 0x8000)
 	{
-		size_t bank = _rom_bank_low;
-		if (bank == 0)
-			bank = 1;
-		if (!_ram_mode)
-			bank |= _ram_rom_bank << 5;
-		size_t rom_addr = addr - 0x4000 + bank * 0x4000;
-		if (rom_addr < _rom.data().size())
-		{
-			value = _rom.data()[rom_addr];
-		}
-		else
-		{
-			debug("WARNING: invalid read from ROM bank, too high ", addr);
-			value = 0;
-		}
+		value = _rom.bank(rom_bank())[addr - 0x4000];
 		return true;
 	}
 	else if (0xA000 <= addr && addr < 0xC000)
 	{
-		auto ram_addr = to_ram_addr(addr);
-		if (true || ram_addr < _rom.ram_size())  // TODO this check?
-		{
-			value = _ram[ram_addr];
-		}
-		else
-		{
-			debug("WARNING: invalid read in RAM, too high ", addr);
-			value = 0;
-		}
+		value = _ram.size() != 0 ? _ram[to_ram_addr(addr)] : 0xFF;
 		return true;
 	}
 	else
@@ -83,17 +58,9 @@ bool gb::cart_mbc1::write8(uint16_t addr, uint8_t value)
 	}
 	else if (0xA000 <= addr && addr < 0xC000)
 	{
-		if (_ram_enabled)
+		if (_ram_enabled && _ram.size() != 0)
 		{
-			auto ram_addr = to_ram_addr(addr);
-			if (ram_addr < _rom.ram_size())
-			{
-				_ram[ram_addr] = value;
-			}
-			else
-			{
-				debug("WARNING: invalid write in RAM, too high ", addr);
-			}
+			_ram.write(to_ram_addr(addr), value);
 		}
 		return true;
 	}
@@ -103,10 +70,73 @@ bool gb::cart_mbc1::write8(uint16_t addr, uint8_t value)
 	}
 }
 
+bool gb::cart_mbc1::read_page(uint16_t addr, const uint8_t *&page) const
+{
+	addr &= 0xFF00;
+	if (addr < 0x4000)
+	{
+		page = &_rom.data()[addr];
+		return true;
+	}
+	else if (0x4000 <= addr && addr < 0x8000)
+	{
+		page = _rom.bank(rom_bank()) + (addr - 0x4000);
+		return true;
+	}
+	else if (0xA000 <= addr && addr < 0xC000)
+	{
+		page = _ram.size() != 0 ? &_ram[to_ram_addr(addr)] : nullptr;
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+int gb::cart_mbc1::rom_bank() const
+{
+	int bank = _rom_bank_low;
+	if (bank == 0)
+		bank = 1;
+	if (!_ram_mode)
+		bank |= _ram_rom_bank << 5;
+	return bank;
+}
+
+void gb::cart_mbc1::save()
+{
+	_ram.flush();
+}
+
 size_t gb::cart_mbc1::to_ram_addr(uint16_t addr) const
 {
 	size_t bank = 0;
 	if (_ram_mode)
 		bank = _ram_rom_bank;
-	return addr - 0xA000 + 0x2000 * bank;
+	return _ram.wrap(addr - 0xA000 + 0x2000 * bank);
+}
+
+uint64_t gb::cart_mbc1::state_hash(uint64_t seed)
+{
+	const uint64_t registers[] = {_rom_bank_low, _ram_rom_bank, static_cast<uint64_t>(_ram_mode), static_cast<uint64_t>(_ram_enabled)};
+	return _ram.hash(hash64(registers, sizeof(registers), seed));
+}
+
+void gb::cart_mbc1::save_state(state_writer &state) const
+{
+	state.write(_ram_enabled);
+	state.write(_rom_bank_low);
+	state.write(_ram_rom_bank);
+	state.write(_ram_mode);
+	_ram.save_state(state);
+}
+
+void gb::cart_mbc1::load_state(state_reader &state)
+{
+	state.read(_ram_enabled);
+	state.read(_rom_bank_low);
+	state.read(_ram_rom_bank);
+	state.read(_ram_mode);
+	_ram.load_state(state);
 }
@@ -1,8 +1,10 @@
 #pragma once
 #include "memory.hpp"
 #include "rom.hpp"
+#include "cart_ram.hpp"
 #include <array>
 #include <cstdint>
+#include <string>
 
 namespace gb
 {
@@ -13,10 +15,18 @@ public:
 	static const uint8_t enable_ram_mask = 0x0A;
 	static const uint8_t ram_mode_mask = 0x01;
 
-	cart_mbc1(rom rom);
+	/** The RAM is saved to save_path if it is not empty. */
+	cart_mbc1(rom rom, const std::string &save_path = std::string());
 
 	bool read8(uint16_t addr, uint8_t &value) const override;
 	bool write8(uint16_t addr, uint8_t value) override;
+	bool read_page(uint16_t addr, const uint8_t *&page) const override;
+	int rom_bank() const override;
+	uint64_t state_hash(uint64_t seed) override;
+	dirty_pages *ram_dirty() override { return &_ram.dirty(); }
+	void save_state(state_writer &state) const override;
+	void load_state(state_reader &state) override;
+	void save() override;
 
 private:
 	size_t to_ram_addr(uint16_t addr) const;
@@ -26,7 +36,7 @@ private:
 	uint8_t _rom_bank_low;
 	uint8_t _ram_rom_bank;
 	bool _ram_mode;
-	std::array<uint8_t, 0x8000> _ram;
+	cart_ram _ram;
 };
 
 }
@@ -0,0 +1,135 @@
+#include "cart_mbc2.hpp"
+#include "debug.hpp"
+#include "bits.hpp"
+
+gb::cart_mbc2::cart_mbc2(rom rom, const std::string &save_path) :
+	_rom(std::move(rom)),
+	_ram_enabled(false),
+	_rom_bank(1),
+	_rom_bank_ptr(_rom.bank(1)),
+	_ram(ram_size, save_path)
+{
+}
+
+bool gb::cart_mbc2::read8(uint16_t addr, uint8_t &value) const
+{
+	if (addr < 0x4000)
+	{
+		value = _rom.data()[addr];
+		return true;
+	}
+	else if (addr < 0x8000)
+	{
+		value = _rom_bank_ptr[addr - 0x4000];
+		return true;
+	}
+	else if (0xA000 <= addr && addr < 0xC000)
+	{
+		if (!_ram_enabled)
+		{
+			debug("WARNING: RAM read while not enabled: ", addr);
+		}
+		// Only the low nibble exists, the upper one reads as set
+		value = _ram[_ram.wrap(addr - 0xA000)] | 0xF0;
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+bool gb::cart_mbc2::write8(uint16_t addr, uint8_t value)
+{
+	if (addr < 0x4000)
+	{
+		// Bit 8 of the address selects the register
+		if (addr & 0x0100)
+		{
+			_rom_bank = value & 0x0F;
+			if (_rom_bank == 0)
+				_rom_bank = 1;
+			_rom_bank_ptr = _rom.bank(_rom_bank);
+		}
+		else
+		{
+			_ram_enabled = bit::test(value, enable_ram_mask);
+		}
+		return true;
+	}
+	else if (addr < 0x8000)
+	{
+		return true;
+	}
+	else if (0xA000 <= addr && addr < 0xC000)
+	{
+		if (_ram_enabled)
+		{
+			_ram.write(_ram.wrap(addr - 0xA000), value & 0x0F);
+		}
+		else
+		{
+			debug("WARNING: RAM write while not enabled: ", addr);
+		}
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+bool gb::cart_mbc2::read_page(uint16_t addr, const uint8_t *&page) const
+{
+	addr &= 0xFF00;
+	if (addr < 0x4000)
+	{
+		page = &_rom.data()[addr];
+		return true;
+	}
+	else if (addr < 0x8000)
+	{
+		page = _rom_bank_ptr + (addr - 0x4000);
+		return true;
+	}
+	else if (0xA000 <= addr && addr < 0xC000)
+	{
+		page = nullptr;  // the upper nibbles must be set by read8
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+int gb::cart_mbc2::rom_bank() const
+{
+	return static_cast<int>(_rom_bank);
+}
+
+void gb::cart_mbc2::save()
+{
+	_ram.flush();
+}
+
+uint64_t gb::cart_mbc2::state_hash(uint64_t seed)
+{
+	const uint64_t registers[] = {_rom_bank, static_cast<uint64_t>(_ram_enabled)};
+	return _ram.hash(hash64(registers, sizeof(registers), seed));
+}
+
+void gb::cart_mbc2::save_state(state_writer &state) const
+{
+	state.write(_ram_enabled);
+	state.write(_rom_bank);
+	_ram.save_state(state);
+}
+
+void gb::cart_mbc2::load_state(state_reader &state)
+{
+	state.read(_ram_enabled);
+	state.read(_rom_bank);
+	_rom_bank_ptr = _rom.bank(_rom_bank);
+	_ram.load_state(state);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "memory.hpp"
+#include "rom.hpp"
+#include "cart_ram.hpp"
+#include <string>
+
+namespace gb
+{
+
+/** MBC2 with its built-in 512 x 4 bit RAM, mirrored over A000-BFFF. */
+class cart_mbc2 final : public memory_mapping
+{
+public:
+	static const uint8_t enable_ram_mask = 0x0A;
+	static const size_t ram_size = 512;
+
+	/** The RAM is saved to save_path if it is not empty. */
+	cart_mbc2(rom rom, const std::string &save_path = std::string());
+
+	bool read8(uint16_t addr, uint8_t &value) const override;
+	bool write8(uint16_t addr, uint8_t value) override;
+	bool read_page(uint16_t addr, const uint8_t *&page) const override;
+	int rom_bank() const override;
+	uint64_t state_hash(uint64_t seed) override;
+	dirty_pages *ram_dirty() override { return &_ram.dirty(); }
+	void save_state(state_writer &state) const override;
+	void load_state(state_reader &state) override;
+	void save() override;
+
+private:
+	const rom _rom;
+	bool _ram_enabled;
+	size_t _rom_bank;
+	const uint8_t *_rom_bank_ptr;
+	cart_ram _ram;
+};
+
+}
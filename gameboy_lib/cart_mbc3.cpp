@@ -0,0 +1,273 @@
+#include "cart_mbc3.hpp"
+#include "debug.hpp"
+#include "bits.hpp"
+#include <algorithm>
+#include <chrono>
+
+const uint8_t gb::cart_mbc3::rtc_halt_mask;
+const uint8_t gb::cart_mbc3::rtc_carry_mask;
+
+namespace
+{
+
+using days = std::chrono::duration<long long, std::ratio<86400>>;
+
+const days rtc_day_range(512);
+
+}
+
+gb::cart_mbc3::cart_mbc3(rom rom, const cputime &clock, bool rtc, const std::string &save_path) :
+	_rom(std::move(rom)),
+	_clock(clock),
+	_has_rtc(rtc),
+	_ram_enabled(false),
+	_rom_bank(1),
+	_ram_select(0),
+	_latch(0xFF),
+	_ram(_rom.ram_size(), save_path),
+	_ram_mask(std::min<size_t>(_ram.size(), 0x2000) - 1),
+	_rtc_start(clock),
+	_rtc_halted_counter(0),
+	_rtc_halted(false),
+	_rtc_carry(false),
+	_rtc_latched{}
+{
+	update_banks();
+}
+
+bool gb::cart_mbc3::read8(uint16_t addr, uint8_t &value) const
+{
+	if (addr < 0x4000)
+	{
+		value = _rom.data()[addr];
+		return true;
+	}
+	else if (addr < 0x8000)
+	{
+		value = _rom_bank_ptr[addr - 0x4000];
+		return true;
+	}
+	else if (0xA000 <= addr && addr < 0xC000)
+	{
+		if (!_ram_enabled)
+		{
+			debug("WARNING: RAM read while not enabled: ", addr);
+		}
+		if (_ram_bank_ptr)
+			value = _ram_bank_ptr[(addr - 0xA000) & _ram_mask];
+		else if (_has_rtc && 0x08 <= _ram_select && _ram_select <= 0x0C)
+			value = _rtc_latched[_ram_select - 0x08];
+		else
+			value = 0xFF;
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+bool gb::cart_mbc3::write8(uint16_t addr, uint8_t value)
+{
+	if (addr < 0x2000)
+	{
+		_ram_enabled = bit::test(value, enable_ram_mask);
+		return true;
+	}
+	else if (addr < 0x4000)
+	{
+		_rom_bank = value & 0x7F;
+		if (_rom_bank == 0)
+			_rom_bank = 1;
+		update_banks();
+		return true;
+	}
+	else if (addr < 0x6000)
+	{
+		_ram_select = value & 0x0F;
+		update_banks();
+		return true;
+	}
+	else if (addr < 0x8000)
+	{
+		// Writing 0 and then 1 latches the clock
+		if (_has_rtc && _latch == 0x00 && value == 0x01)
+			latch_rtc();
+		_latch = value;
+		return true;
+	}
+	else if (0xA000 <= addr && addr < 0xC000)
+	{
+		if (!_ram_enabled)
+		{
+			debug("WARNING: RAM write while not enabled: ", addr);
+		}
+		else if (_ram_bank_ptr)
+		{
+			_ram.write(_ram_bank_offset + ((addr - 0xA000) & _ram_mask), value);
+		}
+		else if (_has_rtc && 0x08 <= _ram_select && _ram_select <= 0x0C)
+		{
+			write_rtc(_ram_select - 0x08, value);
+		}
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+bool gb::cart_mbc3::read_page(uint16_t addr, const uint8_t *&page) const
+{
+	addr &= 0xFF00;
+	if (addr < 0x4000)
+	{
+		page = &_rom.data()[addr];
+		return true;
+	}
+	else if (addr < 0x8000)
+	{
+		page = _rom_bank_ptr + (addr - 0x4000);
+		return true;
+	}
+	else if (0xA000 <= addr && addr < 0xC000)
+	{
+		page = _ram_bank_ptr ? _ram_bank_ptr + ((addr - 0xA000) & _ram_mask) : nullptr;
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+int gb::cart_mbc3::rom_bank() const
+{
+	return static_cast<int>(_rom_bank);
+}
+
+void gb::cart_mbc3::save()
+{
+	_ram.flush();
+}
+
+void gb::cart_mbc3::update_banks()
+{
+	_rom_bank_ptr = _rom.bank(_rom_bank);
+	_ram_bank_offset = _ram.wrap(_ram_select * 0x2000);
+	if (_ram_select < 0x04 && _ram.size() != 0)
+		_ram_bank_ptr = &_ram[_ram_bank_offset];
+	else
+		_ram_bank_ptr = nullptr;
+}
+
+gb::cputime gb::cart_mbc3::rtc_counter()
+{
+	auto counter = _rtc_halted ? _rtc_halted_counter : _clock - _rtc_start;
+	if (counter >= rtc_day_range)
+	{
+		_rtc_carry = true;
+		counter %= std::chrono::duration_cast<cputime>(rtc_day_range);
+		set_rtc_counter(counter);
+	}
+	return counter;
+}
+
+void gb::cart_mbc3::set_rtc_counter(cputime counter)
+{
+	if (_rtc_halted)
+		_rtc_halted_counter = counter;
+	else
+		_rtc_start = _clock - counter;
+}
+
+void gb::cart_mbc3::latch_rtc()
+{
+	const auto secs = std::chrono::duration_cast<std::chrono::seconds>(rtc_counter()).count();
+	const auto day = secs / 86400;
+	_rtc_latched[rtc_seconds] = static_cast<uint8_t>(secs % 60);
+	_rtc_latched[rtc_minutes] = static_cast<uint8_t>(secs / 60 % 60);
+	_rtc_latched[rtc_hours] = static_cast<uint8_t>(secs / 3600 % 24);
+	_rtc_latched[rtc_day_low] = static_cast<uint8_t>(day);
+	_rtc_latched[rtc_day_high] = static_cast<uint8_t>((day >> 8) & 0x01) |
+		(_rtc_halted ? rtc_halt_mask : 0) | (_rtc_carry ? rtc_carry_mask : 0);
+}
+
+void gb::cart_mbc3::write_rtc(int reg, uint8_t value)
+{
+	const auto counter = rtc_counter();
+	const auto secs = std::chrono::duration_cast<std::chrono::seconds>(counter).count();
+	long long s = secs % 60;
+	long long m = secs / 60 % 60;
+	long long h = secs / 3600 % 24;
+	long long d = secs / 86400;
+	auto fraction = counter - std::chrono::duration_cast<cputime>(std::chrono::seconds(secs));
+
+	switch (reg)
+	{
+	case rtc_seconds:
+		s = value & 0x3F;
+		fraction = cputime(0);  // resets the prescaler
+		break;
+	case rtc_minutes:
+		m = value & 0x3F;
+		break;
+	case rtc_hours:
+		h = value & 0x1F;
+		break;
+	case rtc_day_low:
+		d = (d & 0x100) | value;
+		break;
+	default:
+		d = (d & 0xFF) | ((value & 0x01) << 8);
+		_rtc_carry = bit::test(value, rtc_carry_mask);
+		if (bit::test(value, rtc_halt_mask) && !_rtc_halted)
+		{
+			_rtc_halted_counter = counter;
+			_rtc_halted = true;
+		}
+		else if (!bit::test(value, rtc_halt_mask) && _rtc_halted)
+		{
+			_rtc_halted = false;
+		}
+		break;
+	}
+
+	set_rtc_counter(std::chrono::seconds(((d * 24 + h) * 60 + m) * 60 + s) + fraction);
+}
+
+uint64_t gb::cart_mbc3::state_hash(uint64_t seed)
+{
+	const uint64_t registers[] = {_rom_bank, static_cast<uint64_t>(_ram_select), static_cast<uint64_t>(_ram_enabled)};
+	return _ram.hash(hash64(registers, sizeof(registers), seed));
+}
+
+void gb::cart_mbc3::save_state(state_writer &state) const
+{
+	state.write(_ram_enabled);
+	state.write(_rom_bank);
+	state.write(_ram_select);
+	state.write(_latch);
+	state.write(_rtc_start);
+	state.write(_rtc_halted_counter);
+	state.write(_rtc_halted);
+	state.write(_rtc_carry);
+	state.write(_rtc_latched);
+	_ram.save_state(state);
+}
+
+void gb::cart_mbc3::load_state(state_reader &state)
+{
+	state.read(_ram_enabled);
+	state.read(_rom_bank);
+	state.read(_ram_select);
+	state.read(_latch);
+	state.read(_rtc_start);
+	state.read(_rtc_halted_counter);
+	state.read(_rtc_halted);
+	state.read(_rtc_carry);
+	state.read(_rtc_latched);
+	_ram.load_state(state);
+	update_banks();
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "memory.hpp"
+#include "rom.hpp"
+#include "cart_ram.hpp"
+#include "time.hpp"
+#include <array>
+#include <string>
+
+namespace gb
+{
+
+/**
+ * MBC3, optionally with the real time clock. The clock isn't ticked, its counter is derived
+ * from the emulated time (read from clock) when it is latched or written.
+ */
+class cart_mbc3 final : public memory_mapping
+{
+public:
+	static const uint8_t enable_ram_mask = 0x0A;
+	static const uint8_t rtc_halt_mask = 0x40;
+	static const uint8_t rtc_carry_mask = 0x80;
+
+	/** The RAM is saved to save_path if it is not empty, clock is the emulated time for the RTC. */
+	cart_mbc3(rom rom, const cputime &clock, bool rtc, const std::string &save_path = std::string());
+
+	bool read8(uint16_t addr, uint8_t &value) const override;
+	bool write8(uint16_t addr, uint8_t value) override;
+	bool read_page(uint16_t addr, const uint8_t *&page) const override;
+	int rom_bank() const override;
+	uint64_t state_hash(uint64_t seed) override;
+	dirty_pages *ram_dirty() override { return &_ram.dirty(); }
+	void save_state(state_writer &state) const override;
+	void load_state(state_reader &state) override;
+	void save() override;
+
+private:
+	enum rtc_register { rtc_seconds, rtc_minutes, rtc_hours, rtc_day_low, rtc_day_high, rtc_count };
+
+	void update_banks();
+
+	/** Time counted by the RTC, normalized to 512 days (setting the carry). */
+	cputime rtc_counter();
+	void set_rtc_counter(cputime counter);
+	void latch_rtc();
+	void write_rtc(int reg, uint8_t value);
+
+	const rom _rom;
+	const cputime &_clock;
+	bool _has_rtc;
+	bool _ram_enabled;
+	size_t _rom_bank;
+	uint8_t _ram_select;  // RAM bank 0-3 or RTC register 8-C
+	uint8_t _latch;
+	cart_ram _ram;
+	size_t _ram_mask;
+	const uint8_t *_rom_bank_ptr;
+	const uint8_t *_ram_bank_ptr;  // nullptr without RAM or with a RTC register selected
+	size_t _ram_bank_offset;
+
+	// Running: counter = clock - _rtc_start, halted: counter = _rtc_halted_counter
+	cputime _rtc_start;
+	cputime _rtc_halted_counter;
+	bool _rtc_halted;
+	bool _rtc_carry;
+	std::array<uint8_t, rtc_count> _rtc_latched;
+};
+
+}
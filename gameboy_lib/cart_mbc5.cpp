@@ -1,11 +1,14 @@
 #include "cart_mbc5.hpp"
 #include "debug.hpp"
 #include "bits.hpp"
+#include <algorithm>
 
-gb::cart_mbc5::cart_mbc5(rom rom) :
-	_ram_enabled(false), _rom_bank(0), _ram_bank(0), _rom(std::move(rom))
+gb::cart_mbc5::cart_mbc5(rom rom, const std::string &save_path, bool rumble) :
+	_ram_enabled(false), _rom_bank(0), _ram_bank(0), _has_rumble(rumble), _rumble_on(false),
+	_rom(std::move(rom)), _ram(_rom.ram_size(), save_path),
+	_ram_mask(std::min<size_t>(_ram.size(), 0x2000) - 1)
 {
-	std::fill(_ram.begin(), _ram.end(), 0);
+	update_banks();
 }
 
 bool gb::cart_mbc5::read8(uint16_t addr, uint8_t &value) const
@@ -17,16 +20,7 @@ bool gb::cart_mbc5::read8(uint16_t addr, uint8_t &value) const
 	}
 	else if (addr < 0x8000)
 	{
-		auto real_addr = (addr - 0x4000) + (_rom_bank * 0x4000);
-		if (real_addr < _rom.data().size())
-		{
-			value = _rom.data()[real_addr];
-		}
-		else
-		{
-			debug("WARNING: Read after end of ROM: ", real_addr);
-			value = 0;
-		}
+		value = _rom_bank_ptr[addr - 0x4000];
 		return true;
 	}
 	else if (0xA000 <= addr && addr < 0xC000)
@@ -35,8 +29,7 @@ bool gb::cart_mbc5::read8(uint16_t addr, uint8_t &value) const
 		{
 			debug("WARNING: RAM read while not enabled: ", addr);
 		}
-		auto real_addr = (addr - 0xA000) + (_ram_bank * 0x2000);
-		value = _ram[real_addr];
+		value = _ram_bank_ptr ? _ram_bank_ptr[(addr - 0xA000) & _ram_mask] : 0xFF;
 		return true;
 	}
 	else
@@ -55,24 +48,35 @@ bool gb::cart_mbc5::write8(uint16_t addr, uint8_t value)
 	else if (addr < 0x3000)
 	{
 		_rom_bank = (_rom_bank & ~0xFF) | value;
+		update_banks();
 		return true;
 	}
 	else if (addr < 0x4000)
 	{
 		_rom_bank = (_rom_bank & 0xFF) | ((value & 0x01) << 8);
+		update_banks();
 		return true;
 	}
 	else if (addr < 0x6000)
 	{
-		_ram_bank = value & 0x0F;
+		if (_has_rumble)
+		{
+			_rumble_on = bit::test(value, rumble_mask);
+			_ram_bank = value & 0x07;
+		}
+		else
+		{
+			_ram_bank = value & 0x0F;
+		}
+		update_banks();
 		return true;
 	}
 	else if (0xA000 <= addr && addr < 0xC000)
 	{
 		if (_ram_enabled)
 		{
-			auto real_addr = (addr - 0xA000) + (_ram_bank * 0x2000);
-			_ram[real_addr] = value;
+			if (_ram_bank_ptr)
+				_ram.write(_ram_bank_offset + ((addr - 0xA000) & _ram_mask), value);
 		}
 		else
 		{
@@ -85,3 +89,69 @@ bool gb::cart_mbc5::write8(uint16_t addr, uint8_t value)
 		return false;
 	}
 }
+
+bool gb::cart_mbc5::read_page(uint16_t addr, const uint8_t *&page) const
+{
+	addr &= 0xFF00;
+	if (addr < 0x4000)
+	{
+		page = &_rom.data()[addr];
+		return true;
+	}
+	else if (addr < 0x8000)
+	{
+		page = _rom_bank_ptr + (addr - 0x4000);
+		return true;
+	}
+	else if (0xA000 <= addr && addr < 0xC000)
+	{
+		page = _ram_bank_ptr ? _ram_bank_ptr + ((addr - 0xA000) & _ram_mask) : nullptr;
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+int gb::cart_mbc5::rom_bank() const
+{
+	return static_cast<int>(_rom_bank);
+}
+
+void gb::cart_mbc5::save()
+{
+	_ram.flush();
+}
+
+void gb::cart_mbc5::update_banks()
+{
+	_rom_bank_ptr = _rom.bank(_rom_bank);
+	_ram_bank_offset = _ram.wrap(_ram_bank * 0x2000);
+	_ram_bank_ptr = _ram.size() != 0 ? &_ram[_ram_bank_offset] : nullptr;
+}
+
+uint64_t gb::cart_mbc5::state_hash(uint64_t seed)
+{
+	const uint64_t registers[] = {_rom_bank, _ram_bank, static_cast<uint64_t>(_ram_enabled)};
+	return _ram.hash(hash64(registers, sizeof(registers), seed));
+}
+
+void gb::cart_mbc5::save_state(state_writer &state) const
+{
+	state.write(_ram_enabled);
+	state.write(_rom_bank);
+	state.write(_ram_bank);
+	state.write(_rumble_on);
+	_ram.save_state(state);
+}
+
+void gb::cart_mbc5::load_state(state_reader &state)
+{
+	state.read(_ram_enabled);
+	state.read(_rom_bank);
+	state.read(_ram_bank);
+	state.read(_rumble_on);
+	_ram.load_state(state);
+	update_banks();
+}
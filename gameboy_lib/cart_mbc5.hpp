@@ -1,7 +1,8 @@
 #pragma once
 #include "memory.hpp"
 #include "rom.hpp"
-#include <array>
+#include "cart_ram.hpp"
+#include <string>
 
 namespace gb
 {
@@ -10,18 +11,42 @@ class cart_mbc5 : public memory_mapping
 {
 public:
 	static const uint8_t enable_ram_mask = 0x0A;
+	static const uint8_t rumble_mask = 0x08;
 
-	cart_mbc5(rom rom);
+	/**
+	 * The RAM is saved to save_path if it is not empty. With rumble, bit 3 of the RAM bank
+	 * register drives the motor instead of selecting a bank.
+	 */
+	cart_mbc5(rom rom, const std::string &save_path = std::string(), bool rumble = false);
 
 	bool read8(uint16_t addr, uint8_t &value) const override;
 	bool write8(uint16_t addr, uint8_t value) override;
+	bool read_page(uint16_t addr, const uint8_t *&page) const override;
+	int rom_bank() const override;
+	uint64_t state_hash(uint64_t seed) override;
+	dirty_pages *ram_dirty() override { return &_ram.dirty(); }
+	void save_state(state_writer &state) const override;
+	void load_state(state_reader &state) override;
+	void save() override;
+
+	/** The rumble motor is on. */
+	bool rumble() const { return _rumble_on; }
 
 private:
+	/** Bank switches update the pointers, so accesses don't compute addresses. */
+	void update_banks();
+
 	bool _ram_enabled;
 	size_t _rom_bank;
 	size_t _ram_bank;
-	std::array<uint8_t, 0x2000 * 0x10> _ram;
+	bool _has_rumble;
+	bool _rumble_on;
 	rom _rom;
+	cart_ram _ram;
+	size_t _ram_mask;
+	const uint8_t *_rom_bank_ptr;
+	const uint8_t *_ram_bank_ptr;  // nullptr without RAM
+	size_t _ram_bank_offset;
 };
 
 }
@@ -0,0 +1,111 @@
+#include "cart_ram.hpp"
+#include "debug.hpp"
+#include "assert.hpp"
+#include <algorithm>
+#include <fstream>
+
+#ifndef _MSC_VER
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+gb::cart_ram::cart_ram(size_t size, const std::string &save_path) :
+	_data(nullptr),
+	_size(size),
+	_save_path(save_path),
+	_mapped(false),
+	_dirty(size),
+	_hashes(size)
+{
+	ASSERT(size == 0 || (size >= 0x100 && (size & (size - 1)) == 0));
+
+#ifndef _MSC_VER
+	if (battery() && _size != 0)
+	{
+		const int fd = ::open(_save_path.c_str(), O_RDWR | O_CREAT, 0644);
+		struct stat st;
+		if (fd < 0 || ::fstat(fd, &st) != 0)
+		{
+			debug("WARNING: can't open save file ", _save_path, ", the RAM won't be saved");
+		}
+		else if (static_cast<size_t>(st.st_size) < _size && ::ftruncate(fd, static_cast<off_t>(_size)) != 0)
+		{
+			debug("WARNING: can't resize save file ", _save_path, ", the RAM won't be saved");
+		}
+		else
+		{
+			void *mapping = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (mapping == MAP_FAILED)
+			{
+				debug("WARNING: can't map save file ", _save_path, ", the RAM won't be saved");
+			}
+			else
+			{
+				_data = static_cast<uint8_t *>(mapping);
+				_mapped = true;
+			}
+		}
+		if (fd >= 0)
+		{
+			::close(fd);  // the mapping stays valid
+		}
+		if (!_mapped)
+		{
+			_save_path.clear();
+		}
+	}
+#endif
+
+	if (!_mapped)
+	{
+		_memory.resize(_size, 0);
+		_data = _memory.data();
+		if (battery())
+		{
+			std::ifstream in(_save_path, std::ios::binary);
+			in.read(reinterpret_cast<char *>(_data), static_cast<std::streamsize>(_size));
+		}
+	}
+}
+
+gb::cart_ram::~cart_ram()
+{
+#ifndef _MSC_VER
+	if (_mapped)
+	{
+		::msync(_data, _size, MS_SYNC);
+		::munmap(_data, _size);
+		return;
+	}
+#endif
+	flush();
+}
+
+void gb::cart_ram::flush()
+{
+	if (!battery())
+	{
+		return;
+	}
+
+#ifndef _MSC_VER
+	if (_mapped)
+	{
+		::msync(_data, _size, MS_ASYNC);
+		return;
+	}
+#endif
+
+	std::fstream out(_save_path, std::ios::binary | std::ios::in | std::ios::out);  // keeps the tail
+	if (!out.is_open())
+	{
+		out.open(_save_path, std::ios::binary | std::ios::out);
+	}
+	out.write(reinterpret_cast<const char *>(_data), static_cast<std::streamsize>(_size));
+	if (!out.good())
+	{
+		debug("WARNING: can't write save file ", _save_path);
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "state_hash.hpp"
+#include "save_state.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace gb
+{
+
+/**
+ * RAM of a cartridge. Battery backed RAM (with a save path) is a memory mapped save file, so
+ * writes never do any I/O. flush writes the changes back asynchronously, the destructor waits.
+ * Without mmap (Windows) the file is read at construction and written by flush. A shorter save
+ * file is grown, the tail of a longer one (e.g. an RTC footer of other emulators) is kept.
+ *
+ * The size is 0 or a power of two of at least 256 byte (from the ROM header).
+ */
+class cart_ram
+{
+public:
+	explicit cart_ram(size_t size, const std::string &save_path = std::string());
+	~cart_ram();
+
+	cart_ram(const cart_ram &) = delete;
+	cart_ram &operator=(const cart_ram &) = delete;
+
+	const uint8_t &operator[](size_t i) const { return _data[i]; }
+	void write(size_t i, uint8_t value) { _data[i] = value; _dirty.mark(i); }
+	const uint8_t *data() const { return _data; }
+	size_t size() const { return _size; }
+	/** Index of a banked address, out of range banks wrap around like with the real address lines. */
+	size_t wrap(size_t addr) const { return addr & (_size - 1); }
+
+	/** Written pages, the hash is one consumer. */
+	dirty_pages &dirty() { return _dirty; }
+	uint64_t hash(uint64_t seed) { return _hashes.update(_data, _dirty, seed); }
+
+	/** The contents as part of a save state, loading marks all pages dirty. */
+	void save_state(state_writer &state) const { state.write(_data, _size); }
+	void load_state(state_reader &state) { state.read(_data, _size); _dirty.mark(0, _size); }
+
+	bool battery() const { return !_save_path.empty(); }
+	void flush();
+
+private:
+	uint8_t *_data;
+	size_t _size;
+	std::string _save_path;
+	std::vector<uint8_t> _memory;  // if not mapped
+	bool _mapped;
+	dirty_pages _dirty;
+	page_hashes _hashes;
+};
+
+}
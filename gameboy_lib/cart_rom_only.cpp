@@ -1,9 +1,10 @@
 #include "cart_rom_only.hpp"
+#include <algorithm>
 
 gb::cart_rom_only::cart_rom_only(rom rom) :
-	_rom(std::move(rom))
+	_rom(std::move(rom)),
+	_ram(std::min<size_t>(_rom.ram_size(), 0x2000))
 {
-	std::fill(_ram.begin(), _ram.end(), 0);
 }
 
 bool gb::cart_rom_only::read8(uint16_t addr, uint8_t &value) const
@@ -15,7 +16,7 @@ bool gb::cart_rom_only::read8(uint16_t addr, uint8_t &value) const
 	}
 	else if (0xA000 <= addr && addr < 0xC000)
 	{
-		value = _ram[addr - 0xA000];
+		value = _ram.size() != 0 ? _ram[_ram.wrap(addr - 0xA000)] : 0xFF;
 		return true;
 	}
 	else
@@ -28,7 +29,8 @@ bool gb::cart_rom_only::write8(uint16_t addr, uint8_t value)
 {
 	if (0xA000 <= addr && addr < 0xC000)
 	{
-		_ram[addr - 0xA000] = value;
+		if (_ram.size() != 0)
+			_ram.write(_ram.wrap(addr - 0xA000), value);
 		return true;
 	}
 	else
@@ -36,3 +38,42 @@ bool gb::cart_rom_only::write8(uint16_t addr, uint8_t value)
 		return false;
 	}
 }
+
+bool gb::cart_rom_only::read_page(uint16_t addr, const uint8_t *&page) const
+{
+	addr &= 0xFF00;
+	if (addr < 0x8000)
+	{
+		page = &_rom.data()[addr];
+		return true;
+	}
+	else if (0xA000 <= addr && addr < 0xC000)
+	{
+		page = _ram.size() != 0 ? &_ram[_ram.wrap(addr - 0xA000)] : nullptr;
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+int gb::cart_rom_only::rom_bank() const
+{
+	return 1;
+}
+
+uint64_t gb::cart_rom_only::state_hash(uint64_t seed)
+{
+	return _ram.hash(seed);
+}
+
+void gb::cart_rom_only::save_state(state_writer &state) const
+{
+	_ram.save_state(state);
+}
+
+void gb::cart_rom_only::load_state(state_reader &state)
+{
+	_ram.load_state(state);
+}
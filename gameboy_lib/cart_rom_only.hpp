@@ -1,7 +1,7 @@
 #pragma once
 #include "memory.hpp"
 #include "rom.hpp"
-#include <array>
+#include "cart_ram.hpp"
 
 namespace gb
 {
@@ -13,10 +13,16 @@ public:
 
 	bool read8(uint16_t addr, uint8_t &value) const override;
 	bool write8(uint16_t addr, uint8_t value) override;
+	bool read_page(uint16_t addr, const uint8_t *&page) const override;
+	int rom_bank() const override;
+	uint64_t state_hash(uint64_t seed) override;
+	dirty_pages *ram_dirty() override { return &_ram.dirty(); }
+	void save_state(state_writer &state) const override;
+	void load_state(state_reader &state) override;
 
 private:
 	const rom _rom;
-	std::array<uint8_t, 0x2000> _ram;
+	cart_ram _ram;
 };
 
 }
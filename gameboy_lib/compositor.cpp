@@ -0,0 +1,142 @@
+#include "compositor.hpp"
+#include "assert.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+	#define GB_X86_64 1
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define GB_TARGET_AVX2
+	#else
+		#define GB_TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#else
+	#define GB_X86_64 0
+#endif
+
+namespace
+{
+
+const uint8_t color_mask = 0x03;
+const uint8_t index_mask = 0x1F;
+const uint8_t priority_mask = 0x80;
+const uint8_t obj_offset = 0x20;
+
+void compose_scalar(const uint8_t *bg, const uint8_t *obj, uint8_t *out, size_t count)
+{
+	for (size_t x = 0; x < count; ++x)
+	{
+		const bool hidden = (bg[x] & color_mask) != 0 && ((bg[x] | obj[x]) & priority_mask) != 0;
+		if ((obj[x] & color_mask) != 0 && !hidden)
+			out[x] = obj_offset | (obj[x] & index_mask);
+		else
+			out[x] = bg[x] & index_mask;
+	}
+}
+
+#if GB_X86_64
+
+// Same as compose_scalar with masks: show = obj opaque and not (bg opaque and a priority flag)
+void compose_sse2(const uint8_t *bg, const uint8_t *obj, uint8_t *out, size_t count)
+{
+	const auto zero = _mm_setzero_si128();
+	const auto ones = _mm_set1_epi8(-1);
+	const auto colors = _mm_set1_epi8(color_mask);
+	const auto indices = _mm_set1_epi8(index_mask);
+	const auto priority = _mm_set1_epi8(static_cast<char>(priority_mask));
+	const auto offset = _mm_set1_epi8(obj_offset);
+
+	size_t x = 0;
+	for (; x + 16 <= count; x += 16)
+	{
+		const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bg + x));
+		const auto o = _mm_loadu_si128(reinterpret_cast<const __m128i *>(obj + x));
+		const auto bg_clear = _mm_cmpeq_epi8(_mm_and_si128(b, colors), zero);
+		const auto obj_clear = _mm_cmpeq_epi8(_mm_and_si128(o, colors), zero);
+		const auto no_priority = _mm_cmpeq_epi8(_mm_and_si128(_mm_or_si128(b, o), priority), zero);
+		const auto hidden = _mm_andnot_si128(_mm_or_si128(bg_clear, no_priority), ones);
+		const auto show = _mm_andnot_si128(_mm_or_si128(obj_clear, hidden), ones);
+		const auto obj_index = _mm_or_si128(_mm_and_si128(o, indices), offset);
+		const auto bg_index = _mm_and_si128(b, indices);
+		const auto result = _mm_or_si128(_mm_and_si128(show, obj_index), _mm_andnot_si128(show, bg_index));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), result);
+	}
+	compose_scalar(bg + x, obj + x, out + x, count - x);
+}
+
+GB_TARGET_AVX2
+void compose_avx2(const uint8_t *bg, const uint8_t *obj, uint8_t *out, size_t count)
+{
+	const auto zero = _mm256_setzero_si256();
+	const auto ones = _mm256_set1_epi8(-1);
+	const auto colors = _mm256_set1_epi8(color_mask);
+	const auto indices = _mm256_set1_epi8(index_mask);
+	const auto priority = _mm256_set1_epi8(static_cast<char>(priority_mask));
+	const auto offset = _mm256_set1_epi8(obj_offset);
+
+	size_t x = 0;
+	for (; x + 32 <= count; x += 32)
+	{
+		const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bg + x));
+		const auto o = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(obj + x));
+		const auto bg_clear = _mm256_cmpeq_epi8(_mm256_and_si256(b, colors), zero);
+		const auto obj_clear = _mm256_cmpeq_epi8(_mm256_and_si256(o, colors), zero);
+		const auto no_priority = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_or_si256(b, o), priority), zero);
+		const auto hidden = _mm256_andnot_si256(_mm256_or_si256(bg_clear, no_priority), ones);
+		const auto show = _mm256_andnot_si256(_mm256_or_si256(obj_clear, hidden), ones);
+		const auto obj_index = _mm256_or_si256(_mm256_and_si256(o, indices), offset);
+		const auto bg_index = _mm256_and_si256(b, indices);
+		const auto result = _mm256_blendv_epi8(bg_index, obj_index, show);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x), result);
+	}
+	compose_sse2(bg + x, obj + x, out + x, count - x);
+}
+
+#endif
+
+}
+
+gb::simd gb::detect_simd()
+{
+#if GB_X86_64
+	#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		const bool avx2 = (info[1] & (1 << 5)) != 0;
+		__cpuid(info, 1);
+		const bool os_avx = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+		if (avx2 && os_avx)
+			return simd::avx2;
+	}
+	#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return simd::avx2;
+	#endif
+	return simd::sse2;  // always there on x86-64
+#else
+	return simd::none;
+#endif
+}
+
+void gb::compose_line(simd level, const uint8_t *bg, const uint8_t *obj, uint8_t *out, size_t count)
+{
+	switch (level)
+	{
+#if GB_X86_64
+	case simd::avx2:
+		compose_avx2(bg, obj, out, count);
+		break;
+	case simd::sse2:
+		compose_sse2(bg, obj, out, count);
+		break;
+#endif
+	default:
+		ASSERT(level == simd::none);
+		compose_scalar(bg, obj, out, count);
+		break;
+	}
+}
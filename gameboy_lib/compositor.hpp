@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace gb
+{
+
+/** Instruction set used by compose_line. */
+enum class simd
+{
+	none,
+	sse2,
+	avx2,
+};
+
+/** Best instruction set supported by the CPU (CPUID). */
+simd detect_simd();
+
+/**
+ * Merges the background and the sprite layer of a line. Pixels of both layers are bytes with
+ * the color index in bits 0-1, the palette in bits 2-4 and a priority flag in bit 7 (BG-to-OBJ
+ * priority of the tile or OBJ-behind-BG of the sprite). Sprite pixels with color 0 are
+ * transparent and a priority flag hides the sprite behind BG colors 1-3.
+ *
+ * The result is an index into the 64 colors of the background (0-31) and sprite (32-63) palettes.
+ * All levels give exactly the same result.
+ */
+void compose_line(simd level, const uint8_t *bg, const uint8_t *obj, uint8_t *out, size_t count);
+
+}
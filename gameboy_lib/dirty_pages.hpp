@@ -0,0 +1,67 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gb
+{
+
+/**
+ * The epoch of the last write to each 256 byte page of a memory, set by its write paths. Every
+ * consumer (e.g. the state hash) keeps the epoch it has seen and only looks at the pages written
+ * since, so consumers don't clear the pages for each other. A consumer starting at epoch 0 sees
+ * all pages as dirty.
+ */
+class dirty_pages
+{
+public:
+	static const size_t page_size = 0x100;
+
+	explicit dirty_pages(size_t bytes) :
+		_written((bytes + page_size - 1) / page_size, 1),
+		_epoch(1)
+	{
+	}
+
+	/** Marks the page of a written byte. */
+	void mark(size_t offset) { _written[offset / page_size] = _epoch; }
+	void mark(size_t offset, size_t size)
+	{
+		if (size == 0)
+			return;
+		std::fill(_written.begin() + offset / page_size, _written.begin() + (offset + size - 1) / page_size + 1, _epoch);
+	}
+
+	size_t pages() const { return _written.size(); }
+	/** True if the page was written after the epoch seen. */
+	bool test(size_t page, uint64_t seen) const { return _written[page] > seen; }
+	bool any(uint64_t seen) const
+	{
+		return std::any_of(_written.begin(), _written.end(), [seen](uint64_t epoch) { return epoch > seen; });
+	}
+
+	/** Calls f(page) for each page written after the epoch seen, in ascending order. */
+	template <typename F>
+	void for_each(uint64_t seen, F f) const
+	{
+		for (size_t page = 0; page < _written.size(); ++page)
+		{
+			if (_written[page] > seen)
+				f(page);
+		}
+	}
+
+	/**
+	 * Ends the current epoch and returns it, a consumer keeps it as the epoch it has seen once it
+	 * looked at the dirty pages.
+	 */
+	uint64_t checkpoint() { return _epoch++; }
+	uint64_t epoch() const { return _epoch; }
+
+private:
+	std::vector<uint64_t> _written;  // epoch of the last write per page
+	uint64_t _epoch;
+};
+
+}
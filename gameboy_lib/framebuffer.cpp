@@ -0,0 +1,37 @@
+#include "framebuffer.hpp"
+#include "assert.hpp"
+
+size_t gb::pixel_size(pixel_format format)
+{
+	switch (format)
+	{
+	case pixel_format::rgb888:
+		return 3;
+	case pixel_format::rgba8888:
+		return 4;
+	case pixel_format::rgb565:
+		return 2;
+	default:
+		ASSERT(format == pixel_format::indexed || format == pixel_format::gray8);
+		return 1;
+	}
+}
+
+uint32_t gb::pack_pixel(pixel_format format, const std::array<uint8_t, 3> &rgb, uint8_t index)
+{
+	// little endian: the lowest byte is first in memory
+	switch (format)
+	{
+	case pixel_format::rgb888:
+		return rgb[0] | rgb[1] << 8 | rgb[2] << 16;
+	case pixel_format::rgba8888:
+		return rgb[0] | rgb[1] << 8 | rgb[2] << 16 | 0xFFu << 24;
+	case pixel_format::rgb565:
+		return (rgb[0] >> 3) << 11 | (rgb[1] >> 2) << 5 | rgb[2] >> 3;
+	case pixel_format::gray8:
+		return (rgb[0] * 77 + rgb[1] * 150 + rgb[2] * 29) >> 8;  // BT.601 weights
+	default:
+		ASSERT(format == pixel_format::indexed);
+		return index;
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace gb
+{
+
+enum class pixel_format
+{
+	rgb888,    // 3 byte R, G, B
+	rgba8888,  // 4 byte R, G, B, A (255)
+	rgb565,    // 16 bit little endian, red in the high bits
+	indexed,   // 1 byte index into the 64 palette colors (see video::palette)
+	gray8,     // 1 byte luminance
+};
+
+size_t pixel_size(pixel_format format);
+
+/** Packs a color for a format (the index for indexed), the bytes are in memory order. */
+uint32_t pack_pixel(pixel_format format, const std::array<uint8_t, 3> &rgb, uint8_t index);
+
+/**
+ * The part of the screen that goes into a frame and the integer factor it is shrunk by.
+ * Shrinking averages the blocks in gray8 and takes their top left pixel in the other formats.
+ */
+struct frame_view
+{
+	int left, top, width, height;  // screen pixels, multiples of scale
+	int scale;
+
+	int frame_width() const { return width / scale; }
+	int frame_height() const { return height / scale; }
+};
+
+/** An image in memory, not owned. Line y starts at data + y * stride. */
+struct framebuffer
+{
+	uint8_t *data;
+	size_t stride;
+	pixel_format format;
+
+	uint8_t *line(int y) const { return data + y * stride; }
+};
+
+}
@@ -4,6 +4,8 @@
 #include "rom.hpp"
 #include "cart_rom_only.hpp"
 #include "cart_mbc1.hpp"
+#include "cart_mbc2.hpp"
+#include "cart_mbc3.hpp"
 #include "cart_mbc5.hpp"
 #include "internal_ram.hpp"
 #include "video.hpp"
@@ -15,14 +17,26 @@
 #include <cstdlib>
 #include <vector>
 #include <fstream>
+#include <sstream>
 #include <memory>
 #include <chrono>
+#include <algorithm>
 
 namespace
 {
 class stop_exception {};
 
-std::unique_ptr<gb::memory_mapping> init_cartridge(gb::rom rom)
+// Upper bound of a single halted tick, if no peripheral will ever raise an interrupt.
+const gb::cputime max_halt_skip(912);
+
+// Bound of the emulation of one frame ahead, which doesn't end while the LCD is off.
+const gb::cputime max_frame_time(2 * 154 * 912);
+
+// Battery backed RAM is written back to the save file at least this often.
+const std::chrono::seconds save_interval(1);
+
+std::unique_ptr<gb::memory_mapping> init_cartridge(gb::rom rom, const gb::cputime &clock,
+	const std::string &save_path)
 {
 	switch (rom.cartridge())
 	{
@@ -30,12 +44,31 @@ std::unique_ptr<gb::memory_mapping> init_cartridge(gb::rom rom)
 		return std::make_unique<gb::cart_rom_only>(std::move(rom));
 	case 0x01:  // MBC1
 	case 0x02:  // MBC1+RAM
-	case 0x03:  // MBC1+RAM+BATTERY
 		return std::make_unique<gb::cart_mbc1>(std::move(rom));
+	case 0x03:  // MBC1+RAM+BATTERY
+		return std::make_unique<gb::cart_mbc1>(std::move(rom), save_path);
+	case 0x05:  // MBC2
+		return std::make_unique<gb::cart_mbc2>(std::move(rom));
+	case 0x06:  // MBC2+BATTERY
+		return std::make_unique<gb::cart_mbc2>(std::move(rom), save_path);
+	case 0x0F:  // MBC3+TIMER+BATTERY
+	case 0x10:  // MBC3+TIMER+RAM+BATTERY
+		return std::make_unique<gb::cart_mbc3>(std::move(rom), clock, true, save_path);
+	case 0x11:  // MBC3
+	case 0x12:  // MBC3+RAM
+		return std::make_unique<gb::cart_mbc3>(std::move(rom), clock, false);
+	case 0x13:  // MBC3+RAM+BATTERY
+		return std::make_unique<gb::cart_mbc3>(std::move(rom), clock, false, save_path);
 	case 0x19:  // MBC5
 	case 0x1A:  // MBC5+RAM
-	case 0x1B:  // MBC5+RAM+BATTERY
 		return std::make_unique<gb::cart_mbc5>(std::move(rom));
+	case 0x1B:  // MBC5+RAM+BATTERY
+		return std::make_unique<gb::cart_mbc5>(std::move(rom), save_path);
+	case 0x1C:  // MBC5+RUMBLE
+	case 0x1D:  // MBC5+RUMBLE+RAM
+		return std::make_unique<gb::cart_mbc5>(std::move(rom), std::string(), true);
+	case 0x1E:  // MBC5+RUMBLE+RAM+BATTERY
+		return std::make_unique<gb::cart_mbc5>(std::move(rom), save_path, true);
 	default:
 		throw gb::unsupported_rom_exception("Unknown cartridge type");
 	}
@@ -100,27 +133,143 @@ std::unique_ptr<gb::z80_cpu> init_cpu(gb::memory_mapping &cart, gb::internal_ram
 
 }
 
-gb::gb_hardware::gb_hardware(rom arg_rom) :
-	cartridge(init_cartridge(std::move(arg_rom))),
-	cpu(init_cpu(*cartridge, internal_ram, video, timer, joypad, sound))
+gb::gb_hardware::gb_hardware(rom arg_rom, const std::string &save_path) :
+	elapsed(0),
+	cartridge(init_cartridge(std::move(arg_rom), elapsed, save_path)),
+	cpu(init_cpu(*cartridge, internal_ram, video, timer, joypad, sound)),
+	_recording(nullptr),
+	_playback(nullptr),
+	_playback_next(0),
+	_hash_log(nullptr),
+	_hashed_frames(0),
+	_run_ahead(0),
+	_run_ahead_frame(0)
 {
 }
 
 #define HEAVY_DEBUG 0
 gb::cputime gb::gb_hardware::tick()
+{
+	const auto time = step();
+
+	if (_hash_log && video.frames() != _hashed_frames)
+	{
+		_hashed_frames = video.frames();
+		_hash_log->add(state_hash());
+	}
+	if (_run_ahead > 0 && video.frames() != _run_ahead_frame)
+	{
+		run_frames_ahead();
+	}
+	return time;
+}
+
+gb::cputime gb::gb_hardware::step()
+{
+	if (_playback)
+	{
+		play_input();
+	}
+
+	const auto time = cpu->halted() && !cpu->interrupt_pending() ? tick_halted() : tick_cpu();
+	elapsed += time;
+	return time;
+}
+
+uint64_t gb::gb_hardware::state_hash()
+{
+	const auto &r = cpu->registers();
+	const uint16_t cpu_state[] = {
+		r.read16<register16::af>(), r.read16<register16::bc>(), r.read16<register16::de>(),
+		r.read16<register16::hl>(), r.read16<register16::sp>(), r.read16<register16::pc>(),
+		static_cast<uint16_t>(cpu->ime() | cpu->halted() << 1 | cpu->double_speed() << 2)
+	};
+	auto hash = hash64(cpu_state, sizeof(cpu_state));
+	hash = internal_ram.state_hash(hash);
+	hash = video.state_hash(hash);
+	return cartridge->state_hash(hash);
+}
+
+void gb::gb_hardware::log_hashes(hash_log *log)
+{
+	_hash_log = log;
+	_hashed_frames = video.frames();
+}
+
+void gb::gb_hardware::save_state(std::vector<uint8_t> &state) const
+{
+	state_writer writer(state);
+	writer.write(elapsed);
+	writer.write(_playback_next);
+	cartridge->save_state(writer);
+	internal_ram.save_state(writer);
+	video.save_state(writer);
+	timer.save_state(writer);
+	joypad.save_state(writer);
+	sound.save_state(writer);
+	cpu->save_state(writer);
+}
+
+void gb::gb_hardware::load_state(const std::vector<uint8_t> &state)
+{
+	state_reader reader(state);
+	reader.read(elapsed);
+	reader.read(_playback_next);
+	cartridge->load_state(reader);
+	internal_ram.load_state(reader);
+	video.load_state(reader);
+	timer.load_state(reader);
+	joypad.load_state(reader);
+	sound.load_state(reader);
+	cpu->load_state(reader);
+	ASSERT(reader.done());
+	_hashed_frames = video.frames();
+}
+
+void gb::gb_hardware::set_run_ahead(int frames)
+{
+	ASSERT(frames >= 0);
+	_run_ahead = frames;
+	_run_ahead_frame = video.frames();
+	// the frames which are shown come from run_frames_ahead
+	video.set_drawing(frames == 0);
+}
+
+void gb::gb_hardware::run_frames_ahead()
+{
+	// Nothing of the frames ahead is kept but the last drawn frame, they aren't hashed either
+	save_state(_run_ahead_state);
+	sound.set_muted(true);
+	for (int i = 1; i <= _run_ahead; ++i)
+	{
+		video.set_drawing(i == _run_ahead);
+		const auto frame = video.frames();
+		cputime time(0);
+		while (video.frames() == frame && time < max_frame_time)
+		{
+			time += step();
+		}
+	}
+	video.set_drawing(false);
+	sound.set_muted(false);
+	load_state(_run_ahead_state);
+	_run_ahead_frame = video.frames();
+}
+
+gb::cputime gb::gb_hardware::tick_cpu()
 {
 	const auto time_fde = cpu->fetch_decode_execute();
 #if HEAVY_DEBUG
 	switch (cpu->current_opcode()->extra_bytes)
 	{
 	case 0:
-		debug(cpu->current_opcode()->mnemonic);
+		debug(mnemonic(cpu->current_opcode()));
 		break;
 	case 1:
-		debug(cpu->current_opcode()->mnemonic, "  $=", static_cast<int>(cpu->value8()));
+		debug(mnemonic(cpu->current_opcode()), "  $=", static_cast<int>(cpu->value8()));
 		break;
 	case 2:
-		debug(cpu->current_opcode()->mnemonic, "  $=", static_cast<int>(cpu->value16()));
+		debug(mnemonic(cpu->current_opcode()), "  $=", static_cast<int>(cpu->value16()));
 		break;
 	default:
 		ASSERT_UNREACHABLE();
@@ -134,18 +283,142 @@ gb::cputime gb::gb_hardware::tick()
 	const auto time_w = cpu->write();
 	timer.tick(*cpu, time_w);
 
-	const auto time = time_fde + time_r + time_w;
+	auto time = time_fde + time_r + time_w;
 	video.tick(*cpu, time);
+	time += stall_cpu();
+
+	z80_cpu::idle_loop loop;
+	if (cpu->take_idle_loop(loop))
+	{
+		time += skip_idle_loop(loop);
+	}
 
 #if HEAVY_DEBUG
 	cpu->registers().debug_print();
 #endif
 
+	sound.tick(time);
+	return time;
+}
+
+void gb::gb_hardware::key_down(key key)
+{
+	if (_playback)
+		return;
+	if (_recording)
+		_recording->add({elapsed, key, true});
+	joypad.down(key);
+}
+
+void gb::gb_hardware::key_up(key key)
+{
+	if (_playback)
+		return;
+	if (_recording)
+		_recording->add({elapsed, key, false});
+	joypad.up(key);
+}
+
+void gb::gb_hardware::record(input_movie *movie)
+{
+	_recording = movie;
+}
+
+void gb::gb_hardware::play(const input_movie *movie)
+{
+	_playback = movie;
+	_playback_next = 0;
+	// Events before now are skipped
+	if (_playback)
+	{
+		const auto &events = _playback->events();
+		while (_playback_next < events.size() && events[_playback_next].time < elapsed)
+			++_playback_next;
+	}
+}
+
+void gb::gb_hardware::play_input()
+{
+	// Events are applied at the first instruction boundary at or after their time, which is
+	// where they were recorded, since the run up to there is the same.
+	const auto &events = _playback->events();
+	while (_playback_next < events.size() && events[_playback_next].time <= elapsed)
+	{
+		const auto &event = events[_playback_next++];
+		if (event.pressed)
+			joypad.down(event.key);
+		else
+			joypad.up(event.key);
+	}
+}
+
+gb::cputime gb::gb_hardware::tick_halted()
+{
+	// A halted CPU only burns time until a peripheral raises an interrupt, so all idle
+	// steps up to and including the one in which the next event happens are done at once.
+	// The wake up happens at exactly the same time as with single steps.
+	const auto step = cpu->fetch_decode_execute();
+	const auto until = std::min({timer.time_until_event(*cpu), video.time_until_event(*cpu), max_halt_skip});
+	const auto steps = std::max<cputime::rep>((until + step - cputime(1)) / step, 1);
+	const auto time = steps * step;
+
+	timer.tick(*cpu, time);
+	video.tick(*cpu, time);
+
+	const auto total = time + stall_cpu();
+	sound.tick(total);
+	return total;
+}
+
+gb::cputime gb::gb_hardware::stall_cpu()
+{
+	// The CPU doesn't run during a HDMA/GDMA transfer, but everything else does. A
+	// general purpose DMA can stall for several modes, video handles one per tick.
+	const auto stall = video.take_cpu_stall();
+	auto remaining = stall;
+	while (remaining > cputime(0))
+	{
+		const auto time = std::min(remaining, std::max(video.time_until_event(*cpu), cputime(1)));
+		timer.tick(*cpu, time);
+		video.tick(*cpu, time);
+		remaining -= time;
+	}
+	return stall;
+}
+
+gb::cputime gb::gb_hardware::skip_idle_loop(const z80_cpu::idle_loop &loop)
+{
+	// The CPU is at the start of a polling loop: as long as neither the polled register
+	// changes nor an interrupt can be raised, every iteration does exactly the same, so all
+	// iterations which end before the next event are skipped.
+	if (cpu->interrupt_pending())
+	{
+		return cputime(0);
+	}
+
+	auto until = std::min({timer.time_until_event(*cpu), video.time_until_event(*cpu), max_halt_skip});
+	if (0xFF04 <= loop.polled_addr && loop.polled_addr <= 0xFF07)
+	{
+		until = std::min(until, timer.time_until_change(*cpu, loop.polled_addr));
+	}
+	// video registers and IF only change with video and timer events
+
+	const auto iterations = (until - cputime(1)) / loop.iteration_time;
+	if (iterations <= 0)
+	{
+		return cputime(0);
+	}
+
+	const auto time = iterations * loop.iteration_time;
+	timer.tick(*cpu, time);
+	video.tick(*cpu, time);
 	return time;
 }
 
 gb::gb_thread::gb_thread() :
-	_running(false)
+	_running(false),
+	_play_movie(false),
+	_framebuffer{nullptr, 0, pixel_format::rgb888}
 {
 }
 
@@ -155,10 +428,49 @@ gb::gb_thread::~gb_thread()
 	join();
 }
 
-void gb::gb_thread::start(gb::rom rom)
+void gb::gb_thread::record_movie(const std::string &path)
+{
+	ASSERT(!_running);
+	_movie = input_movie();
+	_record_path = path;
+	_play_movie = false;
+}
+
+void gb::gb_thread::play_movie(const std::string &path)
 {
 	ASSERT(!_running);
-	_gb = std::make_unique<gb_hardware>(std::move(rom));
+	_movie = input_movie(path);
+	_record_path.clear();
+	_play_movie = true;
+}
+
+void gb::gb_thread::log_hashes(const std::string &path)
+{
+	ASSERT(!_running);
+	_hash_log = hash_log();
+	_hash_log_path = path;
+}
+
+void gb::gb_thread::attach_framebuffer(const framebuffer &buffer, video::frame_callback frame_complete)
+{
+	ASSERT(!_running);
+	_framebuffer = buffer;
+	_frame_complete = std::move(frame_complete);
+}
+
+void gb::gb_thread::start(gb::rom rom, const std::string &save_path)
+{
+	ASSERT(!_running);
+	_gb = std::make_unique<gb_hardware>(std::move(rom), save_path);
+	if (!_record_path.empty())
+		_gb->record(&_movie);
+	else if (_play_movie)
+		_gb->play(&_movie);
+	if (!_hash_log_path.empty())
+		_gb->log_hashes(&_hash_log);
+	if (_framebuffer.data != nullptr)
+		_gb->video.attach_framebuffer(_framebuffer);
+	_gb->video.on_frame_complete(_frame_complete);
 	_thread = std::thread(&gb_thread::run, this);
 	_running = true;
 }
@@ -181,13 +493,20 @@ void gb::gb_thread::post_stop()
 	_command_queue.emplace_back(std::move(fn));
 }
 
-std::future<gb::video::raw_image> gb::gb_thread::post_get_image()
+std::future<std::vector<uint8_t>> gb::gb_thread::post_get_frame()
 {
 	// TODO use capture by move (Visual Studio 2015/C++14)
-	auto promise = std::make_shared<std::promise<video::raw_image>>();
+	auto promise = std::make_shared<std::promise<std::vector<uint8_t>>>();
 	auto future = promise->get_future();
 	command fn([this, promise]() {
-		promise->set_value(_gb->video.image());
+		_gb->video.sync();
+		const auto &frame = _gb->video.frame();
+		const auto &view = _gb->video.view();
+		const auto line_size = view.frame_width() * pixel_size(frame.format);
+		std::vector<uint8_t> data(line_size * view.frame_height());
+		for (int y = 0; y < view.frame_height(); ++y)
+			std::copy_n(frame.line(y), line_size, &data[y * line_size]);
+		promise->set_value(std::move(data));
 	});
 
 	std::lock_guard<std::mutex> lock(_mutex);
@@ -195,10 +514,20 @@ std::future<gb::video::raw_image> gb::gb_thread::post_get_image()
 	return future;
 }
 
+void gb::gb_thread::post_set_pixel_format(pixel_format format)
+{
+	command fn([this, format]() {
+		_gb->video.set_pixel_format(format);
+	});
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_command_queue.emplace_back(std::move(fn));
+}
+
 void gb::gb_thread::post_key_down(gb::key key)
 {
 	command fn([this, key]() {
-		_gb->joypad.down(key);
+		_gb->key_down(key);
 	});
 
 	std::lock_guard<std::mutex> lock(_mutex);
@@ -208,13 +537,53 @@ void gb::gb_thread::post_key_down(gb::key key)
 void gb::gb_thread::post_key_up(gb::key key)
 {
 	command fn([this, key]() {
-		_gb->joypad.up(key);
+		_gb->key_up(key);
 	});
 
 	std::lock_guard<std::mutex> lock(_mutex);
 	_command_queue.emplace_back(std::move(fn));
 }
 
+void gb::gb_thread::post_set_run_ahead(int frames)
+{
+	ASSERT(frames >= 0);
+	command fn([this, frames]() {
+		_gb->set_run_ahead(frames);
+	});
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_command_queue.emplace_back(std::move(fn));
+}
+
+void gb::gb_thread::post_set_video_pipelined(bool enabled)
+{
+	command fn([this, enabled]() {
+		_gb->video.set_pipelined(enabled);
+	});
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_command_queue.emplace_back(std::move(fn));
+}
+
+void gb::gb_thread::post_set_profiling(bool enabled)
+{
+	command fn([this, enabled]() {
+		if (enabled && !_profiler.running())
+			_profiler.start(*_gb->cpu, *_gb->cartridge);
+		else if (!enabled)
+			_profiler.stop();
+	});
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_command_queue.emplace_back(std::move(fn));
+}
+
+gb::sound::sample_buffer &gb::gb_thread::audio_samples()
+{
+	ASSERT(_running);
+	return _gb->sound.samples();
+}
+
 void gb::gb_thread::run()
 {
 	using namespace std::chrono;
@@ -238,6 +607,8 @@ void gb::gb_thread::run()
 	nanoseconds performance_sleep_time(0);
 	auto performance_start = clock::now();
 
+	auto last_save = clock::now();
+
 	try
 	{
 		while (true)
@@ -306,14 +677,55 @@ void gb::gb_thread::run()
 				{
 					debug("PERF WARNING: simulation speed is too low (< 110 %)");
 				}
+				if (_profiler.running())
+				{
+					const auto profile = _profiler.report();
+					if (profile.samples != 0)
+					{
+						std::ostringstream out;
+						profiler::print(out, profile);
+						debug(out.str());
+					}
+				}
 				performance_sleep_time = seconds(0);
 				performance_gb_time = cputime(0);
 				performance_start = performance_now;
 			}
+
+			// Battery backed RAM
+			if (performance_now - last_save > save_interval)
+			{
+				_gb->cartridge->save();
+				last_save = performance_now;
+			}
 		}
 	}
 	catch (const stop_exception &)
 	{
 		// this might be ugly but it works well :)
 	}
+
+	// the profiler samples this thread
+	_profiler.stop();
+	_gb->cartridge->save();
+
+	if (!_record_path.empty())
+	{
+		try
+		{
+			_movie.save(_record_path);
+		}
+		catch (const input_movie_error &e)
+		{
+			debug("WARNING: ", e.what());
+		}
+	}
+
+	if (!_hash_log_path.empty())
+	{
+		std::ofstream out(_hash_log_path, std::ios::binary);
+		_hash_log.write(out);
+		if (!out.good())
+			debug("WARNING: can't write the hash log ", _hash_log_path);
+	}
 }
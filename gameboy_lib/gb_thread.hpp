@@ -6,6 +6,9 @@
 #include "joypad.hpp"
 #include "sound.hpp"
 #include "z80.hpp"
+#include "profiler.hpp"
+#include "input_movie.hpp"
+#include "state_hash.hpp"
 #include <thread>
 #include <atomic>
 #include <condition_variable>
@@ -23,7 +26,8 @@ struct unsupported_rom_exception : public std::runtime_error
 
 struct gb_hardware
 {
-	gb_hardware(rom rom);
+	/** Battery backed cartridge RAM is kept in save_path, if not empty. */
+	gb_hardware(rom rom, const std::string &save_path = std::string());
 
 	// This Type is very unmovabe/copyable because pointers everywhere!
 	gb_hardware(gb_hardware &&) = delete;
@@ -33,6 +37,38 @@ struct gb_hardware
 
 	cputime tick();
 
+	/** Key changes, ignored while a movie is played. */
+	void key_down(key key);
+	void key_up(key key);
+	/** Appends all key changes to movie (nullptr to stop). */
+	void record(input_movie *movie);
+	/** Replaces the keys by the events of movie (nullptr to stop), which must outlive the playback. */
+	void play(const input_movie *movie);
+
+	/** Hash of CPU registers, WRAM, VRAM, OAM and cartridge RAM, only dirty pages are hashed again. */
+	uint64_t state_hash();
+	/** Appends the state hash of every frame (at the start of vblank) to log (nullptr to stop). */
+	void log_hashes(hash_log *log);
+
+	/**
+	 * Saves the emulation state between two ticks into state, reusing its memory. Outputs
+	 * (frame, samples), the ROM and the movie and hash log settings aren't part of it. The
+	 * state can only be loaded by the same build with the same ROM.
+	 */
+	void save_state(std::vector<uint8_t> &state) const;
+	void load_state(const std::vector<uint8_t> &state);
+
+	/**
+	 * Shows the frame which is the given number of frames ahead of the emulation (0 to turn it
+	 * off), which hides that much input lag of the game. After every frame tick saves the state,
+	 * emulates the frames ahead with the current keys and without sound, draws only the last of
+	 * them and loads the state again. The frames of the emulation itself aren't drawn.
+	 */
+	void set_run_ahead(int frames);
+	int run_ahead() const { return _run_ahead; }
+
+	/** Emulated time since power on, the clock of the cartridge RTC and of input movies. */
+	cputime elapsed;
 	std::unique_ptr<gb::memory_mapping> cartridge;
 	gb::internal_ram internal_ram;
 	gb::video video;
@@ -40,6 +76,24 @@ struct gb_hardware
 	gb::joypad joypad;
 	gb::sound sound;
 	std::unique_ptr<gb::z80_cpu> cpu;
+
+private:
+	cputime step();
+	void run_frames_ahead();
+	void play_input();
+	cputime tick_cpu();
+	cputime tick_halted();
+	cputime stall_cpu();
+	cputime skip_idle_loop(const z80_cpu::idle_loop &loop);
+
+	input_movie *_recording;
+	const input_movie *_playback;
+	size_t _playback_next;
+	hash_log *_hash_log;
+	uint64_t _hashed_frames;
+	int _run_ahead;  // frames, 0 if off
+	uint64_t _run_ahead_frame;  // the last frame which was run ahead of
+	std::vector<uint8_t> _run_ahead_state;
 };
 
 class gb_thread
@@ -48,18 +102,45 @@ public:
 	gb_thread();
 	~gb_thread();
 
-	/** Starts the thread. */
-	void start(gb::rom rom);
+	/** Records the keys from power on to a movie file, written when the thread stops. Call before start. */
+	void record_movie(const std::string &path);
+	/** Plays the keys of a movie file from power on, throws input_movie_error. Call before start. */
+	void play_movie(const std::string &path);
+
+	/** Writes the state hash of every frame to a hash log file when the thread stops. Call before start. */
+	void log_hashes(const std::string &path);
+
+	/**
+	 * Renders into a buffer of the caller instead of an own frame (see video::attach_framebuffer),
+	 * the callback is called whenever a frame is complete. The lines are written and the callback is
+	 * called on the thread that draws: the emulation thread, or the video pipeline thread while
+	 * pipelined (see post_set_video_pipelined). Both are not the caller's thread, the callback and
+	 * the caller's reads of the buffer have to be synchronized. Call before start.
+	 */
+	void attach_framebuffer(const framebuffer &buffer, video::frame_callback frame_complete);
+
+	/** Starts the thread, battery backed cartridge RAM is kept in save_path. */
+	void start(gb::rom rom, const std::string &save_path = std::string());
 	/** Joins the thread. */
 	void join();
 
 	/** Posts a request to stop the thread. */
 	void post_stop();
-	/** Posts a request to get the current image. */
-	std::future<video::raw_image> post_get_image();
+	/** Posts a request to get a copy of the current frame, with packed lines. */
+	std::future<std::vector<uint8_t>> post_get_frame();
+	/** Posts a request to render in another pixel format from now on. */
+	void post_set_pixel_format(pixel_format format);
 	/** Key events. */
 	void post_key_down(gb::key key);
 	void post_key_up(gb::key key);
+	/** Shows the frame which is the given number of frames ahead (see gb_hardware::set_run_ahead). */
+	void post_set_run_ahead(int frames);
+	/** Draws the lines on another thread or on the emulation thread again. */
+	void post_set_video_pipelined(bool enabled);
+	/** Starts or stops the sampling profiler, it reports together with the performance stats. */
+	void post_set_profiling(bool enabled);
+	/** Audio output of the running emulation, to be consumed by exactly one thread. */
+	sound::sample_buffer &audio_samples();
 
 private:
 	// Client Data
@@ -69,6 +150,14 @@ private:
 	// Server Data
 	void run();
 	std::unique_ptr<gb_hardware> _gb;
+	profiler _profiler;
+	input_movie _movie;
+	std::string _record_path;  // empty if not recording
+	bool _play_movie;
+	hash_log _hash_log;
+	std::string _hash_log_path;  // empty if not logging
+	framebuffer _framebuffer;  // null data for an own frame
+	video::frame_callback _frame_complete;
 
 	// Shared Data
 	using command = std::function<void ()>;
@@ -0,0 +1,80 @@
+#include "input_movie.hpp"
+#include "assert.hpp"
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+
+const char *const header = "gbmovie 1";
+
+const std::array<const char *, 8> key_names{{
+	"right", "left", "up", "down", "a", "b", "select", "start"
+}};
+
+}
+
+gb::input_movie::input_movie(const std::string &path)
+{
+	std::ifstream in(path);
+	if (!in)
+		throw input_movie_error("Can't open the movie " + path);
+	read(in);
+}
+
+void gb::input_movie::add(const input_event &event)
+{
+	ASSERT(_events.empty() || _events.back().time <= event.time);
+	_events.push_back(event);
+}
+
+void gb::input_movie::read(std::istream &in)
+{
+	std::string line;
+	if (!std::getline(in, line) || line != header)
+		throw input_movie_error("Not a movie (header)");
+
+	_events.clear();
+	int line_number = 1;
+	while (std::getline(in, line))
+	{
+		++line_number;
+		if (line.empty())
+			continue;
+
+		std::istringstream fields(line);
+		long long time;
+		std::string key, state;
+		if (!(fields >> time >> key >> state))
+			throw input_movie_error("Invalid event in line " + std::to_string(line_number));
+
+		const auto name = std::find_if(key_names.begin(), key_names.end(),
+			[&](const char *n) { return key == n; });
+		if (name == key_names.end() || (state != "down" && state != "up"))
+			throw input_movie_error("Invalid key in line " + std::to_string(line_number));
+		if (!_events.empty() && cputime(time) < _events.back().time)
+			throw input_movie_error("Event out of order in line " + std::to_string(line_number));
+
+		_events.push_back({cputime(time), static_cast<gb::key>(name - key_names.begin()), state == "down"});
+	}
+}
+
+void gb::input_movie::write(std::ostream &out) const
+{
+	out << header << '\n';
+	for (const auto &event : _events)
+	{
+		out << event.time.count() << ' ' << key_names[static_cast<size_t>(event.key)] << ' '
+			<< (event.pressed ? "down" : "up") << '\n';
+	}
+}
+
+void gb::input_movie::save(const std::string &path) const
+{
+	std::ofstream out(path);
+	write(out);
+	if (!out.good())
+		throw input_movie_error("Can't write the movie " + path);
+}
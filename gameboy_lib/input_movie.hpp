@@ -0,0 +1,53 @@
+#pragma once
+#include "joypad.hpp"
+#include "time.hpp"
+#include <iosfwd>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace gb
+{
+
+class input_movie_error : public std::runtime_error
+{
+public:
+	input_movie_error(const std::string &msg) : std::runtime_error(msg) {}
+};
+
+/** A key change at an emulated time (gb_hardware::elapsed since power on). */
+struct input_event
+{
+	cputime time;
+	gb::key key;
+	bool pressed;
+};
+
+/**
+ * Joypad input of a run from power on. gb_hardware applies every event at the first instruction
+ * boundary at or after its time, so playing a movie reproduces the recorded run exactly.
+ *
+ * The file format is text, a "gbmovie 1" line followed by one "<time> <key> <down|up>" line per
+ * event, with the time in cputime units (1/8388608 s).
+ */
+class input_movie
+{
+public:
+	input_movie() = default;
+	/** Throws input_movie_error if the file can't be read or is invalid. */
+	explicit input_movie(const std::string &path);
+
+	/** Events must be added in chronological order. */
+	void add(const input_event &event);
+	const std::vector<input_event> &events() const { return _events; }
+
+	void read(std::istream &in);
+	void write(std::ostream &out) const;
+	/** Throws input_movie_error if the file can't be written. */
+	void save(const std::string &path) const;
+
+private:
+	std::vector<input_event> _events;
+};
+
+}
@@ -1,9 +1,12 @@
 #include "internal_ram.hpp"
+#include "state_hash.hpp"
 
 gb::internal_ram::internal_ram() :
 	_bank(1),
 	_svbk(0),
-	_if(0)
+	_if(0),
+	_dirty(0x8000),
+	_hashes(0x8000)
 {
 	std::fill(_ram.begin(), _ram.end(), 0);
 	std::fill(_high_ram.begin(), _high_ram.end(), 0);
@@ -49,16 +52,19 @@ bool gb::internal_ram::write8(uint16_t addr, uint8_t value)
 	if (0xC000 <= addr && addr < 0xD000)
 	{
 		_ram[addr - 0xC000] = value;
+		_dirty.mark(addr - 0xC000);
 		return true;
 	}
 	else if (0xD000 <= addr && addr < 0xE000)
 	{
 		_ram[addr - 0xD000 + _bank * 0x1000] = value;
+		_dirty.mark(addr - 0xD000 + _bank * 0x1000);
 		return true;
 	}
 	else if (0xE000 <= addr && addr < 0xFE00)
 	{
 		_ram[addr - 0xE000] = value;
+		_dirty.mark(addr - 0xE000);
 		return true;
 	}
 	else if (0xFF80 <= addr)
@@ -81,3 +87,54 @@ bool gb::internal_ram::write8(uint16_t addr, uint8_t value)
 		return false;
 	}
 }
+
+bool gb::internal_ram::read_page(uint16_t addr, const uint8_t *&page) const
+{
+	addr &= 0xFF00;
+	if (0xC000 <= addr && addr < 0xD000)
+	{
+		page = &_ram[addr - 0xC000];
+		return true;
+	}
+	else if (0xD000 <= addr && addr < 0xE000)
+	{
+		page = &_ram[addr - 0xD000 + _bank * 0x1000];
+		return true;
+	}
+	else if (0xE000 <= addr && addr < 0xFE00)
+	{
+		page = &_ram[addr - 0xE000];
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+uint64_t gb::internal_ram::state_hash(uint64_t seed)
+{
+	const uint8_t registers[] = {_svbk, _if};
+	seed = hash64(registers, sizeof(registers), seed);
+	seed = hash64(_high_ram.data(), _high_ram.size(), seed);
+	return _hashes.update(_ram.data(), _dirty, seed);
+}
+
+void gb::internal_ram::save_state(state_writer &state) const
+{
+	state.write(_ram);
+	state.write(_high_ram);
+	state.write(_bank);
+	state.write(_svbk);
+	state.write(_if);
+}
+
+void gb::internal_ram::load_state(state_reader &state)
+{
+	state.read(_ram);
+	state.read(_high_ram);
+	state.read(_bank);
+	state.read(_svbk);
+	state.read(_if);
+	_dirty.mark(0, _ram.size());
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "memory.hpp"
+#include "state_hash.hpp"
 #include <array>
 
 namespace gb
@@ -16,12 +17,21 @@ public:
 
 	bool read8(uint16_t addr, uint8_t &value) const override;
 	bool write8(uint16_t addr, uint8_t value) override;
+	bool read_page(uint16_t addr, const uint8_t *&page) const override;
+	uint64_t state_hash(uint64_t seed) override;
+	void save_state(state_writer &state) const override;
+	void load_state(state_reader &state) override;
+
+	/** Written pages of the WRAM (all banks, C000-CFFF is bank 0). */
+	dirty_pages &dirty() { return _dirty; }
 
 private:
 	std::array<uint8_t, 0x8000> _ram;
 	std::array<uint8_t, 0x80> _high_ram;
 	uint16_t _bank;
 	uint8_t _svbk, _if;
+	dirty_pages _dirty;
+	page_hashes _hashes;
 };
 
 }
@@ -54,3 +54,19 @@ void gb::joypad::up(key key)
 	const auto k = static_cast<int>(key);
 	bit::set(k / 4 == 0 ? _arrows : _buttons, 1 << (k % 4));
 }
+
+void gb::joypad::save_state(state_writer &state) const
+{
+	state.write(_arrows_select);
+	state.write(_buttons_select);
+	state.write(_arrows);
+	state.write(_buttons);
+}
+
+void gb::joypad::load_state(state_reader &state)
+{
+	state.read(_arrows_select);
+	state.read(_buttons_select);
+	state.read(_arrows);
+	state.read(_buttons);
+}
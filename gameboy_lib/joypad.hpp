@@ -26,6 +26,8 @@ public:
 
 	bool read8(uint16_t addr, uint8_t & value) const override;
 	bool write8(uint16_t addr, uint8_t value) override;
+	void save_state(state_writer &state) const override;
+	void load_state(state_reader &state) override;
 
 	void down(key key);
 	void up(key key);
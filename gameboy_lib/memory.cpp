@@ -3,13 +3,56 @@
 #include <algorithm>
 #include <iomanip>
 
-uint8_t gb::memory_map::read8(uint16_t addr) const
+namespace
+{
+
+class dma_bus_lock final : public gb::memory_mapping
+{
+public:
+	bool read8(uint16_t addr, uint8_t &) const override
+	{
+		if (!(0xFF80 <= addr && addr <= 0xFFFE))
+		{
+			debug("WARNING: memory read to non-high-ram while DMA transfer");
+		}
+		return false;
+	}
+
+	bool write8(uint16_t addr, uint8_t) override
+	{
+		if (!(0xFF80 <= addr && addr <= 0xFFFE))
+		{
+			debug("WARNING: memory write to non-high-ram while DMA transfer ignored");
+			// TODO return true;
+		}
+		return false;
+	}
+};
+
+dma_bus_lock bus_lock;
+
+}
+
+void gb::memory_map::set_dma_mode(bool dma)
 {
-	if (_dma_mode && !(0xFF80 <= addr && addr <= 0xFFFE))
+	const bool locked = dma_mode();
+	if (dma && !locked)
+	{
+		_mappings.insert(_mappings.begin(), &bus_lock);
+	}
+	else if (!dma && locked)
 	{
-		debug("WARNING: memory read to non-high-ram while DMA transfer");
+		_mappings.erase(_mappings.begin());
 	}
+}
+
+bool gb::memory_map::dma_mode() const
+{
+	return !_mappings.empty() && _mappings.front() == &bus_lock;
+}
 
+uint8_t gb::memory_map::read8(uint16_t addr) const
+{
 	for (const auto &m : _mappings)
 	{
 		uint8_t value;
@@ -25,12 +68,6 @@ uint8_t gb::memory_map::read8(uint16_t addr) const
 
 void gb::memory_map::write8(uint16_t addr, uint8_t value)
 {
-	if (_dma_mode && !(0xFF80 <= addr && addr <= 0xFFFE))
-	{
-		debug("WARNING: memory write to non-high-ram while DMA transfer ignored");
-		// TODO return;
-	}
-
 	for (const auto &m : _mappings)
 	{
 		if (m->write8(addr, value))
@@ -42,6 +79,19 @@ void gb::memory_map::write8(uint16_t addr, uint8_t value)
 	debug("WARNING: non-mapped write ", addr, ": ", static_cast<int>(value));
 }
 
+const uint8_t *gb::memory_map::read_page(uint16_t addr) const
+{
+	for (const auto &m : _mappings)
+	{
+		const uint8_t *page;
+		if (m->read_page(addr, page))
+		{
+			return page;
+		}
+	}
+	return nullptr;
+}
+
 uint16_t gb::memory_map::read16(uint16_t addr) const
 {
 	uint16_t low = read8(addr);
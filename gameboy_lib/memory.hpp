@@ -1,5 +1,7 @@
 #pragma once
 #include "rom.hpp"
+#include "dirty_pages.hpp"
+#include "save_state.hpp"
 #include <cstdint>
 #include <vector>
 
@@ -13,12 +15,37 @@ public:
 
 	virtual bool read8(uint16_t addr, uint8_t &value) const = 0;
 	virtual bool write8(uint16_t addr, uint8_t value) = 0;
+
+	/**
+	 * Direct access to the 256 byte page containing addr for bulk transfers (DMA). Returns true if
+	 * the address is mapped; page is nullptr if the page is no plain memory and must be read by read8.
+	 */
+	virtual bool read_page(uint16_t /*addr*/, const uint8_t *& /*page*/) const { return false; }
+
+	/** The ROM bank mapped to 4000-7FFF (cartridges only), for diagnostics. */
+	virtual int rom_bank() const { return 0; }
+
+	/** Writes battery backed memory back to its save file (cartridges only). */
+	virtual void save() {}
+
+	/**
+	 * Hash of the memory and registers for comparing runs, seed chains the mappings. Memory
+	 * is hashed incrementally, only the pages written since the last state hash are hashed again.
+	 */
+	virtual uint64_t state_hash(uint64_t seed) { return seed; }
+
+	/** Written pages of the cartridge RAM, nullptr without RAM. */
+	virtual dirty_pages *ram_dirty() { return nullptr; }
+
+	/** Saves or loads the registers and memory, in the same order (see gb_hardware::save_state). */
+	virtual void save_state(state_writer & /*state*/) const {}
+	virtual void load_state(state_reader & /*state*/) {}
 };
 
 class memory_map
 {
 public:
-	memory_map() : _dma_mode(false) {}
+	memory_map() = default;
 
 	void add_mapping(memory_mapping *m) { _mappings.emplace_back(m); }
 
@@ -26,13 +53,19 @@ public:
 	void write8(uint16_t addr, uint8_t value);
 
 	uint16_t read16(uint16_t addr) const;
+	/** Start of the 256 byte page containing addr, nullptr if it must be read byte by byte. */
+	const uint8_t *read_page(uint16_t addr) const;
 	void write16(uint16_t addr, uint16_t value);
 
-	void set_dma_mode(bool dma) { _dma_mode = dma; }
+	/**
+	 * During OAM DMA the CPU can only access high RAM. The bus lock is a mapping in front of
+	 * all others while the transfer runs, so normal accesses don't have to check for it.
+	 */
+	void set_dma_mode(bool dma);
+	bool dma_mode() const;
 
 private:
 	std::vector<memory_mapping *> _mappings;
-	bool _dma_mode;
 };
 
 }
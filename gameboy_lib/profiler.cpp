@@ -0,0 +1,223 @@
+#include "profiler.hpp"
+#include "z80.hpp"
+#include "memory.hpp"
+#include "debug.hpp"
+#include "assert.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+#ifdef __linux__
+	#include <mutex>
+#endif
+
+#ifdef __linux__
+	#include <csignal>
+	#include <ctime>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+	#ifndef sigev_notify_thread_id
+		#define sigev_notify_thread_id _sigev_un._tid
+	#endif
+#endif
+
+GB_PROFILER_THREAD_LOCAL volatile gb::profiler::subsystem gb::profiler::_current = gb::profiler::subsystem::other;
+
+namespace
+{
+
+// The profiler sampling the current thread, the signal is delivered to exactly this thread.
+thread_local gb::profiler *active_profiler = nullptr;
+
+const char *subsystem_names[] = {"other", "cpu", "video", "draw", "timer"};
+
+#ifdef __linux__
+// The SIGPROF handler is process wide, it's installed while any profiler runs.
+std::mutex handler_mutex;
+size_t handler_users = 0;
+struct sigaction previous_handler;
+
+bool install_handler(void (*handler)(int))
+{
+	std::lock_guard<std::mutex> lock(handler_mutex);
+	if (handler_users == 0)
+	{
+		struct sigaction action = {};
+		action.sa_handler = handler;
+		action.sa_flags = SA_RESTART;
+		sigemptyset(&action.sa_mask);
+		if (sigaction(SIGPROF, &action, &previous_handler) != 0)
+		{
+			return false;
+		}
+	}
+	++handler_users;
+	return true;
+}
+
+void remove_handler()
+{
+	std::lock_guard<std::mutex> lock(handler_mutex);
+	ASSERT(handler_users > 0);
+	if (--handler_users == 0)
+	{
+		sigaction(SIGPROF, &previous_handler, nullptr);
+	}
+}
+#endif
+
+}
+
+gb::profiler::profiler() :
+	_running(false),
+	_cpu(nullptr),
+	_cartridge(nullptr),
+	_timer(nullptr),
+	_dropped(0)
+{
+}
+
+gb::profiler::~profiler()
+{
+	stop();
+}
+
+bool gb::profiler::start(const z80_cpu &cpu, const memory_mapping &cartridge, std::chrono::microseconds interval)
+{
+	ASSERT(!_running);
+	if (active_profiler != nullptr)
+	{
+		debug("WARNING: another profiler is already sampling this thread");
+		return false;
+	}
+
+#ifdef __linux__
+	_cpu = &cpu;
+	_cartridge = &cartridge;
+
+	if (!install_handler(&signal_handler))
+	{
+		debug("WARNING: profiler could not install the SIGPROF handler");
+		return false;
+	}
+
+	// CPU time of this thread only, sleeping isn't sampled
+	struct sigevent event = {};
+	event.sigev_notify = SIGEV_THREAD_ID;
+	event.sigev_signo = SIGPROF;
+	event.sigev_notify_thread_id = static_cast<pid_t>(syscall(SYS_gettid));
+	timer_t timer;
+	if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &timer) != 0)
+	{
+		debug("WARNING: profiler could not create the timer");
+		remove_handler();
+		return false;
+	}
+
+	active_profiler = this;
+	_timer = timer;
+	_running = true;
+
+	struct itimerspec spec = {};
+	spec.it_interval.tv_sec = static_cast<time_t>(interval.count() / 1000000);
+	spec.it_interval.tv_nsec = static_cast<long>(interval.count() % 1000000 * 1000);
+	spec.it_value = spec.it_interval;
+	timer_settime(timer, 0, &spec, nullptr);
+	return true;
+#else
+	(void)cpu;
+	(void)cartridge;
+	(void)interval;
+	debug("WARNING: profiler is only supported on Linux");
+	return false;
+#endif
+}
+
+void gb::profiler::stop()
+{
+	if (!_running)
+	{
+		return;
+	}
+
+#ifdef __linux__
+	ASSERT(active_profiler == this);
+	// A signal of the timer is delivered to this thread before timer_delete returns
+	timer_delete(static_cast<timer_t>(_timer));
+	active_profiler = nullptr;
+	remove_handler();
+#endif
+	_timer = nullptr;
+	_running = false;
+}
+
+void gb::profiler::signal_handler(int)
+{
+	if (active_profiler != nullptr)
+	{
+		active_profiler->take_sample();
+	}
+}
+
+void gb::profiler::take_sample()
+{
+	// Runs in the signal handler: no allocation, no locks.
+	sample s;
+	s.pc = _cpu->registers().read16<register16::pc>();
+	s.bank = static_cast<uint16_t>(_cartridge->rom_bank());
+	s.where = _current;
+	if (_samples.push(&s, 1) == 0)
+	{
+		_dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+gb::profiler::profile gb::profiler::report(size_t top)
+{
+	profile p;
+	p.samples = 0;
+	p.dropped = _dropped.exchange(0);
+	std::fill(p.subsystems.begin(), p.subsystems.end(), 0);
+
+	std::unordered_map<uint32_t, size_t> hotspots;  // (bank << 16 | pc)
+	std::array<sample, 0x100> samples;
+	while (const auto n = _samples.pop(samples.data(), samples.size()))
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			++hotspots[static_cast<uint32_t>(samples[i].bank) << 16 | samples[i].pc];
+			++p.subsystems[static_cast<size_t>(samples[i].where)];
+		}
+		p.samples += n;
+	}
+
+	p.hotspots.reserve(hotspots.size());
+	for (const auto &h : hotspots)
+	{
+		p.hotspots.push_back({static_cast<uint16_t>(h.first >> 16), static_cast<uint16_t>(h.first), h.second});
+	}
+	const auto n = std::min(top, p.hotspots.size());
+	std::partial_sort(p.hotspots.begin(), p.hotspots.begin() + n, p.hotspots.end(),
+		[](const hotspot &a, const hotspot &b) { return a.samples > b.samples; });
+	p.hotspots.resize(n);
+	return p;
+}
+
+void gb::profiler::print(std::ostream &out, const profile &p)
+{
+	const auto percent = [&p](size_t samples) { return p.samples == 0 ? 0.0 : 100.0 * samples / p.samples; };
+
+	std::ostringstream text;
+	text << std::fixed << std::setprecision(1) << "PROFILE: " << p.samples << " samples (" << p.dropped << " dropped):";
+	for (size_t i = 0; i < p.subsystems.size(); ++i)
+	{
+		text << " " << subsystem_names[i] << " " << percent(p.subsystems[i]) << " %";
+	}
+	for (const auto &h : p.hotspots)
+	{
+		text << "\nPROFILE:   " << std::hex << std::setfill('0') << std::setw(2) << h.bank << ":" << std::setw(4)
+			<< h.pc << std::dec << "  " << percent(h.samples) << " %";
+	}
+	out << text.str();
+}
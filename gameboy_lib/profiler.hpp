@@ -0,0 +1,115 @@
+#pragma once
+#include "ring_buffer.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Scopes are entered several times per instruction. An extern thread_local is accessed through a
+// check for dynamic initialization, __thread (constant initialization only) is a plain TLS access.
+#ifdef __GNUC__
+	#define GB_PROFILER_THREAD_LOCAL __thread
+#else
+	#define GB_PROFILER_THREAD_LOCAL thread_local
+#endif
+
+namespace gb
+{
+
+class z80_cpu;
+class memory_mapping;
+
+/**
+ * Statistical profiler for the emulation thread. A timer (SIGPROF, thread CPU time) interrupts
+ * the thread and samples the PC, the ROM bank and the subsystem the thread is in. The samples go
+ * into a lock-free buffer and are only evaluated by report, so it is cheap enough to stay on.
+ *
+ * Only available on Linux, start fails elsewhere.
+ */
+class profiler
+{
+public:
+	enum class subsystem : uint8_t
+	{
+		other,
+		cpu,
+		video,
+		draw,   // video::draw_line
+		timer,
+		count
+	};
+
+	/** Marks the subsystem the calling thread is in until the end of the scope. */
+	class scope
+	{
+	public:
+		explicit scope(subsystem s) : _previous(_current) { _current = s; }
+		~scope() { _current = _previous; }
+
+		scope(const scope &) = delete;
+		scope &operator=(const scope &) = delete;
+
+	private:
+		subsystem _previous;
+	};
+
+	profiler();
+	~profiler();
+
+	profiler(const profiler &) = delete;
+	profiler &operator=(const profiler &) = delete;
+
+	struct hotspot
+	{
+		uint16_t bank;
+		uint16_t pc;
+		size_t samples;
+	};
+	/** Aggregated samples. */
+	struct profile
+	{
+		size_t samples;
+		size_t dropped;
+		std::array<size_t, static_cast<size_t>(subsystem::count)> subsystems;
+		std::vector<hotspot> hotspots;  // the most sampled first
+	};
+
+	/**
+	 * Starts sampling the calling thread, at most one profiler per thread. The SIGPROF handler
+	 * is installed while any profiler runs, the previous one is restored afterwards.
+	 */
+	bool start(const z80_cpu &cpu, const memory_mapping &cartridge,
+		std::chrono::microseconds interval = std::chrono::microseconds(1000));
+	/** Must be called from the same thread as start. */
+	void stop();
+	bool running() const { return _running; }
+
+	/** The samples since the last report with the top hotspots. */
+	profile report(size_t top = 10);
+	/** Writes a profile as text, one line per hotspot. */
+	static void print(std::ostream &out, const profile &p);
+
+private:
+	struct sample
+	{
+		uint16_t pc;
+		uint16_t bank;
+		subsystem where;
+	};
+
+	static GB_PROFILER_THREAD_LOCAL volatile subsystem _current;
+	static void signal_handler(int signal);
+	void take_sample();
+
+	bool _running;
+	const z80_cpu *_cpu;
+	const memory_mapping *_cartridge;
+	void *_timer;
+
+	ring_buffer<sample, 0x1000> _samples;
+	std::atomic<size_t> _dropped;
+};
+
+}
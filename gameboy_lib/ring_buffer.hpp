@@ -0,0 +1,65 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace gb
+{
+
+/**
+ * Lock-free ring buffer for exactly one producer and one consumer thread.
+ * push may only be called by the producer, pop/size by the consumer.
+ */
+template <typename T, size_t Capacity>
+class ring_buffer
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	ring_buffer() : _head(0), _tail(0) {}
+
+	ring_buffer(const ring_buffer &) = delete;
+	ring_buffer &operator=(const ring_buffer &) = delete;
+
+	static constexpr size_t capacity() { return Capacity; }
+
+	/** Appends up to count values and returns the number appended, the rest is dropped if full. */
+	size_t push(const T *values, size_t count)
+	{
+		const auto head = _head.load(std::memory_order_relaxed);
+		const auto tail = _tail.load(std::memory_order_acquire);
+		const auto n = std::min(count, Capacity - (head - tail));
+		for (size_t i = 0; i < n; ++i)
+			_data[(head + i) & (Capacity - 1)] = values[i];
+		_head.store(head + n, std::memory_order_release);
+		return n;
+	}
+
+	/** Removes up to count values and returns the number removed. */
+	size_t pop(T *values, size_t count)
+	{
+		const auto tail = _tail.load(std::memory_order_relaxed);
+		const auto head = _head.load(std::memory_order_acquire);
+		const auto n = std::min(count, head - tail);
+		for (size_t i = 0; i < n; ++i)
+			values[i] = _data[(tail + i) & (Capacity - 1)];
+		_tail.store(tail + n, std::memory_order_release);
+		return n;
+	}
+
+	/** Number of values which can be popped. */
+	size_t size() const
+	{
+		return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::array<T, Capacity> _data;
+	// Free running indices, only ever written by their owner. Separate cache lines so the
+	// threads don't fight over them.
+	alignas(64) std::atomic<size_t> _head;
+	alignas(64) std::atomic<size_t> _tail;
+};
+
+}
@@ -75,6 +75,12 @@ gb::rom::rom(std::vector<uint8_t> data_move_from) :
 	case 3:
 		_ram_size = 32 * 1024;
 		break;
+	case 4:
+		_ram_size = 128 * 1024;
+		break;
+	case 5:
+		_ram_size = 64 * 1024;
+		break;
 	default:
 		throw rom_error("The ROM has an invalid ram size field. (" + std::to_string(raw_ram_size) + ")");
 	}
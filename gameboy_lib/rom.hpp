@@ -20,6 +20,8 @@ public:
 	rom(std::vector<uint8_t> data);
 
 	const std::vector<uint8_t> &data() const { return _data; }
+	/** Start of a 16 KB ROM bank, banks after the end of the file wrap around. */
+	const uint8_t *bank(size_t bank) const { return &_data[(bank % (_data.size() / 0x4000)) * 0x4000]; }
 
 	bool valid_logo() const { return _valid_logo; }
 	const std::string &title() const { return _title; }
@@ -0,0 +1,67 @@
+#pragma once
+#include "assert.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace gb
+{
+
+/**
+ * Writes the emulation state as raw values, so it can only be loaded again by the same build
+ * (see gb_hardware::save_state). The memory of the buffer is reused.
+ */
+class state_writer
+{
+public:
+	explicit state_writer(std::vector<uint8_t> &data) : _data(data) { _data.clear(); }
+
+	void write(const void *data, size_t size)
+	{
+		const auto *bytes = static_cast<const uint8_t *>(data);
+		_data.insert(_data.end(), bytes, bytes + size);
+	}
+
+	/** The bytes of a plain value, structs with padding must be written member by member. */
+	template <typename T>
+	void write(const T &value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values can be written");
+		write(&value, sizeof(T));
+	}
+
+private:
+	std::vector<uint8_t> &_data;
+};
+
+/** Reads a state in the order it was written by state_writer. */
+class state_reader
+{
+public:
+	explicit state_reader(const std::vector<uint8_t> &data) : _data(data), _offset(0) {}
+
+	void read(void *data, size_t size)
+	{
+		ASSERT(_offset + size <= _data.size());
+		std::memcpy(data, &_data[_offset], size);
+		_offset += size;
+	}
+
+	template <typename T>
+	void read(T &value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "only plain values can be read");
+		read(&value, sizeof(T));
+	}
+
+	/** True if everything was read. */
+	bool done() const { return _offset == _data.size(); }
+
+private:
+	const std::vector<uint8_t> &_data;
+	size_t _offset;
+};
+
+}
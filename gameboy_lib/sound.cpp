@@ -1,10 +1,81 @@
 #include "sound.hpp"
+#include "bits.hpp"
+#include "assert.hpp"
+#include <algorithm>
+
+const int gb::sound::sample_rate;
+const gb::cputime gb::sound::max_batch_time(140448);  // 70224 clocks at 2^22 Hz
+
+namespace
+{
+
+const gb::cputime::rep frame_sequencer_time = 16384;  // 512 Hz
+const gb::cputime::rep no_clock = gb::cputime::max().count() / 2;
+
+// Unused and write only bits read as 1.
+const std::array<uint8_t, 0x30> read_masks{{
+	0x80, 0x3F, 0x00, 0xFF, 0xBF,  // NR10 - NR14
+	0xFF, 0x3F, 0x00, 0xFF, 0xBF,  // NR20 - NR24
+	0x7F, 0xFF, 0x9F, 0xFF, 0xBF,  // NR30 - NR34
+	0xFF, 0xFF, 0x00, 0x00, 0xBF,  // NR40 - NR44
+	0x00, 0x00, 0x70,              // NR50 - NR52
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // wave pattern RAM
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+}};
+
+// Square wave patterns for 12.5%, 25%, 50% and 75% duty, one bit per step.
+const std::array<uint8_t, 4> duty_patterns{{0x01, 0x81, 0x87, 0x7E}};
+
+// Charge factor of the high pass filter (capacitor) for the output, per sample.
+const float capacitor_charge = 0.996f;
+
+uint16_t channel_register(int ch, int n)
+{
+	return static_cast<uint16_t>(gb::sound::r::nr10 + ch * 5 + n);
+}
+
+}
+
+gb::sound::sound() :
+	_power(true),
+	_sweep_enabled(false),
+	_sweep_timer(0),
+	_sweep_shadow(0),
+	_lfsr(0x7FFF),
+	_frame_sequencer_step(0),
+	_frame_sequencer_timer(frame_sequencer_time),
+	_pending(0),
+	_sample_phase(0),
+	_capacitor_left(0),
+	_capacitor_right(0),
+	_batch_size(0),
+	_status_time(no_clock),
+	_muted(false)
+{
+	std::fill(_registers.begin(), _registers.end(), 0);
+	std::fill(_channels.begin(), _channels.end(), channel{});
+	reg(r::nr52) = 0x80;
+}
 
 bool gb::sound::read8(uint16_t addr, uint8_t &value) const
 {
-	if (0xFF10 <= addr && addr <= 0xFF3F)
+	if (r::nr10 <= addr && addr <= 0xFF3F)
 	{
-		value = _memory[addr - 0xFF10];
+		if (addr == r::nr52)
+		{
+			// Up to date, tick flushes before the channels can run out (see _status_time).
+			value = reg(r::nr52) | read_masks[addr - r::nr10];
+			for (int ch = 0; ch < 4; ++ch)
+			{
+				if (_channels[ch].enabled)
+					value |= 1 << ch;
+			}
+		}
+		else
+		{
+			value = reg(addr) | read_masks[addr - r::nr10];
+		}
 		return true;
 	}
 	else
@@ -15,14 +86,429 @@ bool gb::sound::read8(uint16_t addr, uint8_t &value) const
 
 bool gb::sound::write8(uint16_t addr, uint8_t value)
 {
-	if (0xFF10 <= addr && addr <= 0xFF3F)
+	if (!(r::nr10 <= addr && addr <= 0xFF3F))
 	{
-		_memory[addr - 0xFF10] = value;
+		return false;
+	}
+
+	// everything up to now is generated with the old register values
+	flush();
+
+	if (addr >= r::wave)
+	{
+		reg(addr) = value;
 		return true;
 	}
-	else
+	if (!_power && addr != r::nr52)
 	{
-		return false;
+		// ignored while powered off
+		return true;
+	}
+
+	reg(addr) = value;
+	const auto ch = (addr - r::nr10) / 5;
+	switch (addr)
+	{
+	case r::nr11:
+	case r::nr21:
+	case r::nr41:
+		_channels[ch].length = 64 - (value & 0x3F);
+		break;
+	case r::nr31:
+		_channels[ch].length = 256 - value;
+		break;
+	case r::nr12:
+	case r::nr22:
+	case r::nr42:
+		_channels[ch].dac = (value & 0xF8) != 0;
+		_channels[ch].enabled &= _channels[ch].dac;
+		break;
+	case r::nr30:
+		_channels[ch].dac = bit::test(value, 0x80);
+		_channels[ch].enabled &= _channels[ch].dac;
+		break;
+	case r::nr14:
+	case r::nr24:
+	case r::nr34:
+	case r::nr44:
+		_channels[ch].length_enabled = bit::test(value, 0x40);
+		if (bit::test(value, 0x80))
+			trigger(ch);
+		break;
+	case r::nr52:
+		reg(r::nr52) = value & 0x80;
+		if (!bit::test(value, 0x80) && _power)
+		{
+			power_off();
+		}
+		else if (bit::test(value, 0x80) && !_power)
+		{
+			_power = true;
+			_frame_sequencer_step = 0;
+		}
+		break;
+	default:
+		break;
+	}
+	_status_time = status_change_time();
+	return true;
+}
+
+void gb::sound::tick(cputime time)
+{
+	_pending += time;
+	if (_pending >= max_batch_time || _pending.count() >= _status_time)
+	{
+		flush();
+	}
+}
+
+void gb::sound::flush()
+{
+	auto pending = _pending.count();
+	_pending = cputime(0);
+
+	// Runs in steps up to the next output sample or frame sequencer step, whatever is first.
+	const cputime::rep resolution = cputime::period::den;
+	while (pending > 0)
+	{
+		const auto until_sample = (resolution - _sample_phase + sample_rate - 1) / sample_rate;
+		const auto time = std::min({pending, until_sample, _frame_sequencer_timer});
+		if (_power)
+			advance(time);
+		pending -= time;
+
+		_frame_sequencer_timer -= time;
+		if (_frame_sequencer_timer == 0)
+		{
+			_frame_sequencer_timer = frame_sequencer_time;
+			if (_power)
+				step_frame_sequencer();
+		}
+
+		_sample_phase += time * sample_rate;
+		if (_sample_phase >= resolution)
+		{
+			_sample_phase -= resolution;
+			emit_sample();
+		}
+	}
+
+	_samples.push(_batch.data(), _batch_size);
+	_batch_size = 0;
+	_status_time = status_change_time();
+}
+
+gb::cputime::rep gb::sound::status_change_time() const
+{
+	// Without writes the channels are only disabled by the length counters, which are clocked
+	// on the even frame sequencer steps, and by a sweep overflow, clocked on steps 2 and 6.
+	if (!_power)
+		return no_clock;
+	const int next = _frame_sequencer_step;
+	int steps = -1;  // until the first step that could disable a channel
+	const auto earliest = [&steps](int n) {
+		n = std::max(n, 0);
+		steps = steps < 0 ? n : std::min(steps, n);
+	};
+	for (const auto &c : _channels)
+	{
+		if (c.enabled && c.length_enabled && c.length > 0)
+			earliest(next % 2 + 2 * (c.length - 1));
+	}
+	if (_channels[0].enabled && _sweep_enabled)
+		earliest(((2 - next) & 0x03) + 4 * (_sweep_timer - 1));
+	return steps < 0 ? no_clock : _frame_sequencer_timer + steps * frame_sequencer_time;
+}
+
+int gb::sound::frequency(uint16_t nrx3) const
+{
+	return ((reg(nrx3 + 1) & 0x07) << 8) | reg(nrx3);
+}
+
+gb::cputime::rep gb::sound::period(int ch) const
+{
+	switch (ch)
+	{
+	case 0:
+		return (2048 - frequency(r::nr13)) * 8;
+	case 1:
+		return (2048 - frequency(r::nr23)) * 8;
+	case 2:
+		return (2048 - frequency(r::nr33)) * 4;
+	default:
+	{
+		ASSERT(ch == 3);
+		const auto nr43 = reg(r::nr43);
+		const auto shift = nr43 >> 4;
+		const auto divisor = (nr43 & 0x07) != 0 ? (nr43 & 0x07) * 16 : 8;
+		return shift < 14 ? (divisor << shift) * 2 : no_clock;
+	}
+	}
+}
+
+void gb::sound::trigger(int ch)
+{
+	auto &c = _channels[ch];
+	c.enabled = c.dac;
+	if (c.length == 0)
+		c.length = ch == 2 ? 256 : 64;
+	c.position = 0;
+	c.timer = period(ch);
+
+	if (ch != 2)
+	{
+		const auto nrx2 = reg(channel_register(ch, 2));
+		c.env.volume = nrx2 >> 4;
+		c.env.increase = bit::test(nrx2, 0x08);
+		c.env.period = nrx2 & 0x07;
+		c.env.timer = c.env.period;
+	}
+
+	if (ch == 0)
+	{
+		const auto nr10 = reg(r::nr10);
+		const auto period = (nr10 >> 4) & 0x07;
+		_sweep_shadow = frequency(r::nr13);
+		_sweep_timer = period != 0 ? period : 8;
+		_sweep_enabled = (nr10 & 0x77) != 0;
+		if ((nr10 & 0x07) != 0)
+			sweep_frequency();
+	}
+	else if (ch == 3)
+	{
+		_lfsr = 0x7FFF;
 	}
 }
 
+void gb::sound::power_off()
+{
+	std::fill(_registers.begin(), _registers.begin() + (r::nr52 - r::nr10), 0);
+	std::fill(_channels.begin(), _channels.end(), channel{});
+	_sweep_enabled = false;
+	_power = false;
+}
+
+void gb::sound::step_frame_sequencer()
+{
+	const auto step = _frame_sequencer_step;
+	_frame_sequencer_step = (step + 1) & 0x07;
+
+	if (step % 2 == 0)
+	{
+		for (auto &c : _channels)
+		{
+			if (c.length_enabled && c.length > 0 && --c.length == 0)
+				c.enabled = false;
+		}
+	}
+
+	if (step == 2 || step == 6)
+	{
+		step_sweep();
+	}
+
+	if (step == 7)
+	{
+		for (auto &c : _channels)
+		{
+			auto &e = c.env;
+			if (e.period == 0 || --e.timer != 0)
+				continue;
+			e.timer = e.period;
+			if (e.increase && e.volume < 15)
+				++e.volume;
+			else if (!e.increase && e.volume > 0)
+				--e.volume;
+		}
+	}
+}
+
+void gb::sound::step_sweep()
+{
+	if (--_sweep_timer > 0)
+	{
+		return;
+	}
+
+	const auto nr10 = reg(r::nr10);
+	const auto period = (nr10 >> 4) & 0x07;
+	_sweep_timer = period != 0 ? period : 8;
+	if (!_sweep_enabled || period == 0)
+	{
+		return;
+	}
+
+	const auto f = sweep_frequency();
+	if (f <= 2047 && (nr10 & 0x07) != 0)
+	{
+		_sweep_shadow = f;
+		reg(r::nr13) = f & 0xFF;
+		reg(r::nr14) = (reg(r::nr14) & ~0x07) | (f >> 8);
+		sweep_frequency();  // overflow check only
+	}
+}
+
+int gb::sound::sweep_frequency()
+{
+	const auto nr10 = reg(r::nr10);
+	const auto delta = _sweep_shadow >> (nr10 & 0x07);
+	const auto f = bit::test(nr10, 0x08) ? _sweep_shadow - delta : _sweep_shadow + delta;
+	if (f > 2047)
+		_channels[0].enabled = false;
+	return f;
+}
+
+void gb::sound::advance(cputime::rep time)
+{
+	for (int ch = 0; ch < 4; ++ch)
+	{
+		auto &c = _channels[ch];
+		if (!c.enabled)
+			continue;
+		c.timer -= time;
+		if (c.timer > 0)
+			continue;
+
+		// the period is read on reload, frequency changes apply to the next step
+		const auto p = period(ch);
+		const auto steps = -c.timer / p + 1;
+		c.timer += steps * p;
+		switch (ch)
+		{
+		case 0:
+		case 1:
+			c.position = (c.position + steps) & 0x07;
+			break;
+		case 2:
+			c.position = (c.position + steps) & 0x1F;
+			break;
+		default:
+			for (cputime::rep i = 0; i < steps; ++i)
+			{
+				const uint16_t x = (_lfsr ^ (_lfsr >> 1)) & 0x01;
+				_lfsr = (_lfsr >> 1) | (x << 14);
+				if (bit::test(reg(r::nr43), 0x08))
+					_lfsr = (_lfsr & ~0x40) | (x << 6);
+			}
+			break;
+		}
+	}
+}
+
+int gb::sound::output(int ch) const
+{
+	const auto &c = _channels[ch];
+	switch (ch)
+	{
+	case 0:
+	case 1:
+	{
+		const auto duty = reg(channel_register(ch, 1)) >> 6;
+		return (duty_patterns[duty] >> c.position) & 0x01 ? c.env.volume : 0;
+	}
+	case 2:
+	{
+		const auto volume_code = (reg(r::nr32) >> 5) & 0x03;
+		const auto samples = reg(r::wave + c.position / 2);
+		const auto sample = c.position % 2 == 0 ? samples >> 4 : samples & 0x0F;
+		return volume_code != 0 ? sample >> (volume_code - 1) : 0;
+	}
+	default:
+		ASSERT(ch == 3);
+		return (_lfsr & 0x01) == 0 ? c.env.volume : 0;
+	}
+}
+
+void gb::sound::emit_sample()
+{
+	// The DACs map 0 to 15 to -15 to 15 (in steps of 2), a disabled channel outputs 0.
+	const auto nr51 = reg(r::nr51);
+	int left = 0, right = 0;
+	for (int ch = 0; ch < 4; ++ch)
+	{
+		if (!_channels[ch].dac)
+			continue;
+		const auto value = (_channels[ch].enabled ? output(ch) : 0) * 2 - 15;
+		if (bit::test(nr51, 0x10 << ch))
+			left += value;
+		if (bit::test(nr51, 0x01 << ch))
+			right += value;
+	}
+
+	const auto nr50 = reg(r::nr50);
+	left *= ((nr50 >> 4) & 0x07) + 1;   // -480 to 480
+	right *= (nr50 & 0x07) + 1;
+
+	const float out_left = left - _capacitor_left;
+	_capacitor_left = left - out_left * capacitor_charge;
+	const float out_right = right - _capacitor_right;
+	_capacitor_right = right - out_right * capacitor_charge;
+
+	if (_muted)
+		return;
+
+	const auto to_pcm = [](float value) {
+		return static_cast<int16_t>(std::max(-32768.f, std::min(value * 64, 32767.f)));
+	};
+	_batch[_batch_size++] = {to_pcm(out_left), to_pcm(out_right)};
+	if (_batch_size == _batch.size())
+	{
+		_samples.push(_batch.data(), _batch_size);
+		_batch_size = 0;
+	}
+}
+
+void gb::sound::save_state(state_writer &state) const
+{
+	state.write(_registers);
+	for (const auto &c : _channels)
+	{
+		// each member, the padding isn't part of the state
+		state.write(c.enabled);
+		state.write(c.dac);
+		state.write(c.length_enabled);
+		state.write(c.length);
+		state.write(c.timer);
+		state.write(c.position);
+		state.write(c.env);
+	}
+	state.write(_power);
+	state.write(_sweep_enabled);
+	state.write(_sweep_timer);
+	state.write(_sweep_shadow);
+	state.write(_lfsr);
+	state.write(_frame_sequencer_step);
+	state.write(_frame_sequencer_timer);
+	state.write(_pending);
+	state.write(_sample_phase);
+	state.write(_capacitor_left);
+	state.write(_capacitor_right);
+}
+
+void gb::sound::load_state(state_reader &state)
+{
+	state.read(_registers);
+	for (auto &c : _channels)
+	{
+		state.read(c.enabled);
+		state.read(c.dac);
+		state.read(c.length_enabled);
+		state.read(c.length);
+		state.read(c.timer);
+		state.read(c.position);
+		state.read(c.env);
+	}
+	state.read(_power);
+	state.read(_sweep_enabled);
+	state.read(_sweep_timer);
+	state.read(_sweep_shadow);
+	state.read(_lfsr);
+	state.read(_frame_sequencer_step);
+	state.read(_frame_sequencer_timer);
+	state.read(_pending);
+	state.read(_sample_phase);
+	state.read(_capacitor_left);
+	state.read(_capacitor_right);
+	_status_time = status_change_time();
+}
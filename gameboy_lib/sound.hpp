@@ -1,19 +1,138 @@
 #pragma once
 #include "memory.hpp"
+#include "ring_buffer.hpp"
+#include "time.hpp"
 #include <array>
 
 namespace gb
 {
 
-// TODO implement sound
-class sound : public memory_mapping
+/** One stereo sample. */
+struct audio_frame
+{
+	int16_t left;
+	int16_t right;
+};
+
+/**
+ * The APU: two square channels (the first with sweep), a wave and a noise channel and the
+ * frame sequencer. Samples are not generated per tick but in batches whenever a register
+ * changes, enough time accumulated or a channel could run out.
+ */
+class sound final : public memory_mapping
 {
 public:
+	static const int sample_rate = 48000;
+	/** Samples are generated at least once per this time (one frame). */
+	static const cputime max_batch_time;
+	using sample_buffer = ring_buffer<audio_frame, 0x2000>;
+
+	// Register memory addresses:
+	//   FF10 to FF26
+	//   FF30 to FF3F (wave pattern RAM)
+	struct r
+	{
+		static const uint16_t nr10 = 0xff10;  // channel 1 sweep
+		static const uint16_t nr11 = 0xff11;  // channel 1 duty, length
+		static const uint16_t nr12 = 0xff12;  // channel 1 envelope
+		static const uint16_t nr13 = 0xff13;  // channel 1 frequency low
+		static const uint16_t nr14 = 0xff14;  // channel 1 trigger, length enable, frequency high
+		static const uint16_t nr21 = 0xff16;  // channel 2 duty, length
+		static const uint16_t nr22 = 0xff17;  // channel 2 envelope
+		static const uint16_t nr23 = 0xff18;  // channel 2 frequency low
+		static const uint16_t nr24 = 0xff19;  // channel 2 trigger, length enable, frequency high
+		static const uint16_t nr30 = 0xff1a;  // channel 3 DAC enable
+		static const uint16_t nr31 = 0xff1b;  // channel 3 length
+		static const uint16_t nr32 = 0xff1c;  // channel 3 volume
+		static const uint16_t nr33 = 0xff1d;  // channel 3 frequency low
+		static const uint16_t nr34 = 0xff1e;  // channel 3 trigger, length enable, frequency high
+		static const uint16_t nr41 = 0xff20;  // channel 4 length
+		static const uint16_t nr42 = 0xff21;  // channel 4 envelope
+		static const uint16_t nr43 = 0xff22;  // channel 4 polynomial counter
+		static const uint16_t nr44 = 0xff23;  // channel 4 trigger, length enable
+		static const uint16_t nr50 = 0xff24;  // master volume
+		static const uint16_t nr51 = 0xff25;  // panning
+		static const uint16_t nr52 = 0xff26;  // power, channel status
+		static const uint16_t wave = 0xff30;  // to FF3F
+	};
+
+	sound();
+
 	bool read8(uint16_t addr, uint8_t &value) const override;
 	bool write8(uint16_t addr, uint8_t value) override;
+	/** The state doesn't include the samples, which are output. */
+	void save_state(state_writer &state) const override;
+	void load_state(state_reader &state) override;
+
+	/** Advances the time, cheap unless a batch is due. */
+	void tick(cputime time);
+	/** Generates all samples up to the current time. */
+	void flush();
+
+	/** Output at sample_rate, consumed by a different thread. Full buffers drop samples. */
+	sample_buffer &samples() { return _samples; }
+	/** Drops the samples instead, the sound is still emulated. */
+	void set_muted(bool muted) { _muted = muted; }
 
 private:
-	std::array<uint8_t, 0x30> _memory;
+	struct envelope
+	{
+		uint8_t volume;
+		uint8_t period;
+		uint8_t timer;
+		bool increase;
+	};
+
+	struct channel
+	{
+		bool enabled;
+		bool dac;
+		bool length_enabled;
+		int length;
+		cputime::rep timer;  // until the next waveform step
+		int position;        // in the waveform
+		envelope env;
+	};
+
+	uint8_t &reg(uint16_t addr) { return _registers[addr - r::nr10]; }
+	uint8_t reg(uint16_t addr) const { return _registers[addr - r::nr10]; }
+	int frequency(uint16_t nrx3) const;
+	cputime::rep period(int ch) const;
+
+	void trigger(int ch);
+	void power_off();
+	void step_frame_sequencer();
+	void step_sweep();
+	int sweep_frequency();
+	void advance(cputime::rep time);
+	/** Time from the last flush until the channel status could change without a write. */
+	cputime::rep status_change_time() const;
+	int output(int ch) const;
+	void emit_sample();
+
+	std::array<uint8_t, 0x30> _registers;
+	std::array<channel, 4> _channels;
+	bool _power;
+
+	// channel 1 sweep
+	bool _sweep_enabled;
+	int _sweep_timer;
+	int _sweep_shadow;
+
+	uint16_t _lfsr;  // channel 4
+
+	int _frame_sequencer_step;
+	cputime::rep _frame_sequencer_timer;
+
+	cputime _pending;             // ticked, but no samples generated yet
+	cputime::rep _sample_phase;   // in 1 / (cputime resolution * sample_rate)
+	float _capacitor_left, _capacitor_right;
+
+	std::array<audio_frame, 0x400> _batch;
+	size_t _batch_size;
+	sample_buffer _samples;
+	cputime::rep _status_time;  // status_change_time, tick flushes when it is reached
+	bool _muted;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,148 @@
+#include "state_hash.hpp"
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+namespace
+{
+
+const uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+const uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t prime3 = 0x165667B19E3779F9ULL;
+const uint64_t prime4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t prime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+// little endian hosts only, like the rest of the emulator
+inline uint64_t read64(const uint8_t *p)
+{
+	uint64_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+inline uint32_t read32(const uint8_t *p)
+{
+	uint32_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+inline uint64_t xxh_round(uint64_t acc, uint64_t input)
+{
+	acc += input * prime2;
+	acc = rotl(acc, 31);
+	return acc * prime1;
+}
+
+inline uint64_t merge_round(uint64_t acc, uint64_t value)
+{
+	acc ^= xxh_round(0, value);
+	return acc * prime1 + prime4;
+}
+
+}
+
+uint64_t gb::hash64(const void *data, size_t size, uint64_t seed)
+{
+	const auto *p = static_cast<const uint8_t *>(data);
+	const auto *const end = p + size;
+	uint64_t h;
+
+	if (size >= 32)
+	{
+		uint64_t v1 = seed + prime1 + prime2;
+		uint64_t v2 = seed + prime2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - prime1;
+		do
+		{
+			v1 = xxh_round(v1, read64(p));
+			v2 = xxh_round(v2, read64(p + 8));
+			v3 = xxh_round(v3, read64(p + 16));
+			v4 = xxh_round(v4, read64(p + 24));
+			p += 32;
+		} while (end - p >= 32);
+
+		h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+		h = merge_round(h, v1);
+		h = merge_round(h, v2);
+		h = merge_round(h, v3);
+		h = merge_round(h, v4);
+	}
+	else
+	{
+		h = seed + prime5;
+	}
+
+	h += size;
+
+	for (; end - p >= 8; p += 8)
+	{
+		h ^= xxh_round(0, read64(p));
+		h = rotl(h, 27) * prime1 + prime4;
+	}
+	if (end - p >= 4)
+	{
+		h ^= read32(p) * prime1;
+		h = rotl(h, 23) * prime2 + prime3;
+		p += 4;
+	}
+	for (; p < end; ++p)
+	{
+		h ^= *p * prime5;
+		h = rotl(h, 11) * prime1;
+	}
+
+	h ^= h >> 33;
+	h *= prime2;
+	h ^= h >> 29;
+	h *= prime3;
+	h ^= h >> 32;
+	return h;
+}
+
+uint64_t gb::page_hashes::update(const uint8_t *data, dirty_pages &dirty, uint64_t seed)
+{
+	dirty.for_each(_seen, [&](size_t page) {
+		_hashes[page] = hash64(data + page * dirty_pages::page_size, dirty_pages::page_size);
+	});
+	_seen = dirty.checkpoint();
+	return hash64(_hashes.data(), _hashes.size() * sizeof(uint64_t), seed);
+}
+
+void gb::hash_log::read(std::istream &in)
+{
+	_hashes.clear();
+	uint8_t bytes[8];
+	while (in.read(reinterpret_cast<char *>(bytes), sizeof(bytes)))
+	{
+		_hashes.push_back(read64(bytes));
+	}
+}
+
+void gb::hash_log::write(std::ostream &out) const
+{
+	out.write(reinterpret_cast<const char *>(_hashes.data()),
+		static_cast<std::streamsize>(_hashes.size() * sizeof(uint64_t)));
+}
+
+size_t gb::hash_log::first_difference(const hash_log &a, const hash_log &b)
+{
+	size_t low = 0;
+	size_t high = std::min(a._hashes.size(), b._hashes.size());
+	while (low < high)
+	{
+		const auto mid = low + (high - low) / 2;
+		if (a._hashes[mid] == b._hashes[mid])
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
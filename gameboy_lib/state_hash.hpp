@@ -0,0 +1,55 @@
+#pragma once
+#include "dirty_pages.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace gb
+{
+
+/** Fast non-cryptographic hash (XXH64), seed allows chaining several blocks. */
+uint64_t hash64(const void *data, size_t size, uint64_t seed = 0);
+
+/**
+ * Hashes of the pages of a memory, only the dirty pages are hashed again. The hash of the
+ * memory is the hash of the page hashes.
+ */
+class page_hashes
+{
+public:
+	explicit page_hashes(size_t bytes) : _hashes((bytes + dirty_pages::page_size - 1) / dirty_pages::page_size), _seen(0) {}
+
+	/** Rehashes the pages of data written since the last update and returns the hash of all pages. */
+	uint64_t update(const uint8_t *data, dirty_pages &dirty, uint64_t seed);
+
+private:
+	std::vector<uint64_t> _hashes;
+	uint64_t _seen;  // epoch of dirty
+};
+
+/**
+ * State hash of every frame of a run. Two logs of the same ROM and input are compared by
+ * first_difference, without comparing screenshots. The file format is the little endian
+ * hashes, 8 byte per frame.
+ */
+class hash_log
+{
+public:
+	void add(uint64_t hash) { _hashes.push_back(hash); }
+	const std::vector<uint64_t> &hashes() const { return _hashes; }
+
+	void read(std::istream &in);
+	void write(std::ostream &out) const;
+
+	/**
+	 * First frame which differs in a and b, the size of the shorter log if there is none.
+	 * A run doesn't converge again once it diverged, so this is a binary search.
+	 */
+	static size_t first_difference(const hash_log &a, const hash_log &b);
+
+private:
+	std::vector<uint64_t> _hashes;
+};
+
+}
@@ -1,6 +1,8 @@
 #include "timer.hpp"
 #include "z80.hpp"
+#include "profiler.hpp"
 #include "assert.hpp"
+#include <algorithm>
 
 const gb::cputime gb::timer::tick_time(512);     // 1 / 2^14 == 1 / 2^23 * 2^9
 const gb::cputime gb::timer::tima_0_time(2048);  // 1 / 2^12 == 1 / 2^23 * 2^11
@@ -57,6 +59,7 @@ bool gb::timer::write8(uint16_t addr, uint8_t value)
 
 void gb::timer::tick(z80_cpu &cpu, cputime time)
 {
+	const profiler::scope scope(profiler::subsystem::timer);
 	using namespace std::chrono;
 
 	auto div_increment_at = tick_time;
@@ -71,27 +74,7 @@ void gb::timer::tick(z80_cpu &cpu, cputime time)
 
 	if (_tac & 0x04)
 	{
-		cputime tima_increment_at;
-		switch (_tac & 0x03)
-		{
-		case 0:
-			tima_increment_at = tima_0_time;  // 4096 Hz
-			break;
-		case 1:
-			tima_increment_at = tima_1_time;  // 262144 Hz
-			break;
-		case 2:
-			tima_increment_at = tima_2_time;  // 65536 Hz
-			break;
-		case 3:
-			tima_increment_at = tima_3_time;  // 16384 Hz
-			break;
-		default:
-			ASSERT_UNREACHABLE();
-		}
-		if (cpu.double_speed())
-			tima_increment_at /= 2;
-
+		const auto tima_increment_at = tima_increment_time(cpu);
 		_last_tima_increment += time;
 		while (_last_tima_increment >= tima_increment_at)
 		{
@@ -105,3 +88,74 @@ void gb::timer::tick(z80_cpu &cpu, cputime time)
 		}
 	}
 }
+
+gb::cputime gb::timer::time_until_event(const z80_cpu &cpu) const
+{
+	if ((_tac & 0x04) == 0)
+	{
+		return cputime::max();
+	}
+
+	const auto until = (0x100 - _tima) * tima_increment_time(cpu) - _last_tima_increment;
+	return std::max(until, cputime(0));
+}
+
+gb::cputime gb::timer::time_until_change(const z80_cpu &cpu, uint16_t addr) const
+{
+	switch (addr)
+	{
+	case div:
+		return (cpu.double_speed() ? tick_time / 2 : tick_time) - _last_div_increment;
+	case tima:
+		if ((_tac & 0x04) == 0)
+			return cputime::max();
+		return std::max(tima_increment_time(cpu) - _last_tima_increment, cputime(0));
+	default:
+		return cputime::max();
+	}
+}
+
+gb::cputime gb::timer::tima_increment_time(const z80_cpu &cpu) const
+{
+	cputime tima_increment_at;
+	switch (_tac & 0x03)
+	{
+	case 0:
+		tima_increment_at = tima_0_time;  // 4096 Hz
+		break;
+	case 1:
+		tima_increment_at = tima_1_time;  // 262144 Hz
+		break;
+	case 2:
+		tima_increment_at = tima_2_time;  // 65536 Hz
+		break;
+	case 3:
+		tima_increment_at = tima_3_time;  // 16384 Hz
+		break;
+	default:
+		ASSERT_UNREACHABLE();
+	}
+	if (cpu.double_speed())
+		tima_increment_at /= 2;
+	return tima_increment_at;
+}
+
+void gb::timer::save_state(state_writer &state) const
+{
+	const uint8_t registers[] = {_div, _tima, _tma, _tac};
+	state.write(registers);
+	state.write(_last_div_increment);
+	state.write(_last_tima_increment);
+}
+
+void gb::timer::load_state(state_reader &state)
+{
+	uint8_t registers[4];
+	state.read(registers);
+	_div = registers[0];
+	_tima = registers[1];
+	_tma = registers[2];
+	_tac = registers[3];
+	state.read(_last_div_increment);
+	state.read(_last_tima_increment);
+}
@@ -29,9 +29,17 @@ public:
 
 	bool read8(uint16_t addr, uint8_t & value) const override;
 	bool write8(uint16_t addr, uint8_t value) override;
+	void save_state(state_writer &state) const override;
+	void load_state(state_reader &state) override;
 	void tick(z80_cpu &cpu, cputime time);
+	/** Time until the next TIMA overflow, cputime::max() if the timer is stopped. */
+	cputime time_until_event(const z80_cpu &cpu) const;
+	/** Time until the value of the register changes on its own, cputime::max() if never. */
+	cputime time_until_change(const z80_cpu &cpu, uint16_t addr) const;
 
 private:
+	cputime tima_increment_time(const z80_cpu &cpu) const;
+
 	uint8_t _div, _tima, _tma, _tac;
 	cputime _last_div_increment, _last_tima_increment;
 };
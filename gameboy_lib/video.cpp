@@ -2,36 +2,80 @@
 #include "debug.hpp"
 #include "z80.hpp"
 #include "bits.hpp"
+#include "profiler.hpp"
+#include "state_hash.hpp"
+#include "video_pipeline.hpp"
 #include <bitset>
+#include <cstring>
 #include <algorithm>
 
 const gb::cputime gb::video::dma_time(std::chrono::duration_cast<gb::cputime>(std::chrono::microseconds(160)));
+const gb::cputime gb::video::hdma_block_time(64);  // 8 us, in both speed modes
+
+namespace
+{
+
+// Mode durations, a mode ends as soon as more than this time passed.
+const gb::cputime read_oam_time(160);
+const gb::cputime read_vram_time(344);
+const gb::cputime hblank_time(408);
+const gb::cputime vblank_time(9120);
+const gb::cputime vblank_line_time(912);
+
+}
 
 gb::video::video() :
+	_vram_dirty(sizeof(_vram)),
+	_vram_hashes(sizeof(_vram)),
+	_sprite_lines_valid(false),
+	_sprite_lines_height(0),
+	_check_ly(false),
 	_vram_bank(0),
+	_view{0, 0, width, height, 1},
+	_frame{nullptr, 0, pixel_format::rgb888},
 	_mode_time(0),
+	_vblank_ly_time(0),
 	_hblanks(0),
-	_check_ly(false),
+	_frames(0),
+	_window_line(0),
+	_drawing(true),
 	_dma_starting(false),
 	_dma_running(false),
-	_dma_time_elapsed(0)
+	_dma_time_elapsed(0),
+	_hdma_active(false),
+	_hdma_hblank(false),
+	_hdma_blocks(0),
+	_hdma_source(0),
+	_hdma_dest(0),
+	_cpu_stall(0),
+	_simd(detect_simd())
 {
 	std::fill(_registers.begin(), _registers.end(), 0);
 	for (size_t i = 0; i < _vram.size(); ++i)
 		std::fill(_vram[i].begin(), _vram[i].end(), 0);
+	for (auto &tiles : _tiles)
+		for (auto &tile : tiles)
+			std::fill(tile.begin(), tile.end(), 0);
 	std::fill(_sprite_attribs.begin(), _sprite_attribs.end(), 0);
 	std::fill(_bgp.begin(), _bgp.end(), 0xff);  // all white
 	std::fill(_obp.begin(), _obp.end(), 0);
-	for (auto &row : _image)
-		for (auto &col : row)
-			std::fill(col.begin(), col.end(), 0xFF);
+	for (int i = 0; i < 32; ++i)
+	{
+		update_color(i, true);
+		update_color(i, false);
+	}
+	set_pixel_format(pixel_format::rgb888);
 
 	// starting mode
 	access_register(r::stat) = mode::vblank;
-	_mode_time = cputime(9120 - 1);
+	_mode_time = vblank_time - cputime(1);
 	access_register(r::ly) = 153;
 }
 
+gb::video::~video()
+{
+}
+
 bool gb::video::read8(uint16_t addr, uint8_t &value) const
 {
 	if (0x8000 <= addr && addr < 0xA000)
@@ -109,6 +153,11 @@ bool gb::video::write8(uint16_t addr, uint8_t value)
 		else
 		{
 			_vram[_vram_bank][addr - 0x8000] = value;
+			_vram_dirty.mark(_vram_bank * 0x2000 + addr - 0x8000);
+			if (_pipeline)
+				log({video_event::type::vram, value, static_cast<uint16_t>(_vram_bank * 0x2000 + addr - 0x8000)});
+			else if (addr < 0x9800)
+				decode_tile_row(_vram_bank, addr - 0x8000);
 		}
 		return true;
 	}
@@ -121,6 +170,8 @@ bool gb::video::write8(uint16_t addr, uint8_t value)
 		else
 		{
 			_sprite_attribs[addr - 0xFE00] = value;
+			_sprite_lines_valid = false;
+			log({video_event::type::oam, value, static_cast<uint16_t>(addr - 0xFE00)});
 		}
 		return true;
 	}
@@ -141,6 +192,8 @@ bool gb::video::write8(uint16_t addr, uint8_t value)
 			{
 				uint8_t r = access_register(r::bgpi);
 				_bgp[r & 0x3F] = value;
+				update_color((r & 0x3F) / 2, true);
+				log({video_event::type::bg_palette, value, static_cast<uint16_t>(r & 0x3F)});
 				if ((r & 0x80) != 0)
 					r = 0x80 | (((r & 0x3F) + 1) % _bgp.size());
 				access_register(r::bgpi) = r;
@@ -155,6 +208,8 @@ bool gb::video::write8(uint16_t addr, uint8_t value)
 			{
 				uint8_t r = access_register(r::obpi);
 				_obp[r & 0x3F] = value;
+				update_color((r & 0x3F) / 2, false);
+				log({video_event::type::obj_palette, value, static_cast<uint16_t>(r & 0x3F)});
 				if ((r & 0x80) != 0)
 					r = 0x80 | (((r & 0x3F) + 1) % _obp.size());
 				access_register(r::obpi) = r;
@@ -177,13 +232,32 @@ bool gb::video::write8(uint16_t addr, uint8_t value)
 			access_register(addr) = value;
 			_dma_starting = true;
 			break;
-		case r::hdma1:
-		case r::hdma2:
-		case r::hdma3:
-		case r::hdma4:
 		case r::hdma5:
-			debug("HDMA not implemented");
-			break;  // TODO HDMA
+			if (_hdma_active && _hdma_hblank && !bit::test(value, 0x80))
+			{
+				// stops a running hblank DMA
+				_hdma_active = false;
+				access_register(r::hdma5) = 0x80 | (_hdma_blocks - 1);
+			}
+			else
+			{
+				// the transfer itself is done in tick, a general purpose DMA at the next tick
+				_hdma_active = true;
+				_hdma_hblank = bit::test(value, 0x80);
+				_hdma_blocks = (value & 0x7F) + 1;
+				_hdma_source = ((access_register(r::hdma1) << 8) | access_register(r::hdma2)) & 0xFFF0;
+				_hdma_dest = ((access_register(r::hdma3) << 8) | access_register(r::hdma4)) & 0x1FF0;
+				access_register(r::hdma5) = value & 0x7F;
+			}
+			break;
+		case r::lcdc:
+		case r::scy:
+		case r::scx:
+		case r::wy:
+		case r::wx:
+			access_register(addr) = value;
+			log({video_event::type::reg, value, addr});
+			break;
 		default:
 			access_register(addr) = value;
 			break;
@@ -196,12 +270,107 @@ bool gb::video::write8(uint16_t addr, uint8_t value)
 	}
 }
 
+bool gb::video::read_page(uint16_t addr, const uint8_t *&page) const
+{
+	if (0x8000 <= addr && addr < 0xA000)
+	{
+		page = &_vram[_vram_bank][(addr & 0xFF00) - 0x8000];
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+uint64_t gb::video::state_hash(uint64_t seed)
+{
+	seed = hash64(_registers.data(), _registers.size(), seed);
+	seed = hash64(_bgp.data(), _bgp.size(), seed);
+	seed = hash64(_obp.data(), _obp.size(), seed);
+	seed = hash64(_sprite_attribs.data(), _sprite_attribs.size(), seed);
+	static_assert(sizeof(_vram) == 0x4000, "the VRAM banks must be contiguous");
+	return _vram_hashes.update(_vram[0].data(), _vram_dirty, seed);
+}
+
+void gb::video::save_state(state_writer &state) const
+{
+	state.write(_registers);
+	state.write(_vram);
+	state.write(_sprite_attribs);
+	state.write(_bgp);
+	state.write(_obp);
+	state.write(_vram_bank);
+	state.write(_mode_time);
+	state.write(_vblank_ly_time);
+	state.write(_hblanks);
+	state.write(_frames);
+	state.write(_window_line);
+	state.write(_check_ly);
+	state.write(_dma_starting);
+	state.write(_dma_running);
+	state.write(_dma_time_elapsed);
+	state.write(_hdma_active);
+	state.write(_hdma_hblank);
+	state.write(_hdma_blocks);
+	state.write(_hdma_source);
+	state.write(_hdma_dest);
+	state.write(_cpu_stall);
+}
+
+void gb::video::load_state(state_reader &state)
+{
+	// the renderer is idle after the sync until the next event, it gets the loaded state then
+	sync();
+
+	state.read(_registers);
+	state.read(_vram);
+	state.read(_sprite_attribs);
+	state.read(_bgp);
+	state.read(_obp);
+	state.read(_vram_bank);
+	state.read(_mode_time);
+	state.read(_vblank_ly_time);
+	state.read(_hblanks);
+	state.read(_frames);
+	state.read(_window_line);
+	state.read(_check_ly);
+	state.read(_dma_starting);
+	state.read(_dma_running);
+	state.read(_dma_time_elapsed);
+	state.read(_hdma_active);
+	state.read(_hdma_hblank);
+	state.read(_hdma_blocks);
+	state.read(_hdma_source);
+	state.read(_hdma_dest);
+	state.read(_cpu_stall);
+
+	for (int i = 0; i < 32; ++i)
+	{
+		update_color(i, true);
+		update_color(i, false);
+	}
+	_sprite_lines_valid = false;
+	_vram_dirty.mark(0, sizeof(_vram));
+
+	if (_renderer)
+	{
+		copy_to_renderer();
+		_renderer->decode_tiles();
+		_renderer->update_pixels();
+	}
+	else
+	{
+		decode_tiles();
+	}
+}
+
 bool gb::video::is_register(uint16_t addr)
 {
 	return
 		   0xFF40 <= addr && addr <= 0xFF4B
 		|| addr == 0xFF4F
-		|| 0xFF51 <= addr && addr <= 0xFF50
+		|| 0xFF51 <= addr && addr <= 0xFF55
 		|| 0xFF68 <= addr && addr <= 0xFF6B;
 }
 
@@ -218,6 +387,7 @@ const uint8_t &gb::video::access_register(uint16_t addr) const
 void gb::video::tick(gb::z80_cpu &cpu, cputime time)
 {	
 	using namespace std::chrono;
+	const profiler::scope scope(profiler::subsystem::video);
 
 	if (_dma_running)
 	{
@@ -238,10 +408,22 @@ void gb::video::tick(gb::z80_cpu &cpu, cputime time)
 		}
 		else
 		{
-			uint16_t start_addr = access_register(r::dma) << 8;
-			for (uint16_t i = 0; i < 0xA0; ++i)
+			// straight into OAM, the PPU mode doesn't block the DMA
+			const uint16_t start_addr = access_register(r::dma) << 8;
+			if (const uint8_t *page = cpu.memory().read_page(start_addr))
 			{
-				cpu.memory().write8(0xFE00 + i, cpu.memory().read8(start_addr + i));
+				std::copy_n(page, _sprite_attribs.size(), _sprite_attribs.begin());
+			}
+			else
+			{
+				for (uint16_t i = 0; i < _sprite_attribs.size(); ++i)
+					_sprite_attribs[i] = cpu.memory().read8(start_addr + i);
+			}
+			_sprite_lines_valid = false;
+			if (_pipeline)
+			{
+				for (uint16_t i = 0; i < _sprite_attribs.size(); ++i)
+					log({video_event::type::oam, _sprite_attribs[i], i});
 			}
 
 			_dma_running = true;
@@ -250,11 +432,16 @@ void gb::video::tick(gb::z80_cpu &cpu, cputime time)
 		}
 	}
 
+	if (_hdma_active && !_hdma_hblank)
+	{
+		hdma_transfer(cpu, _hdma_blocks);
+	}
+
 	if ((access_register(r::lcdc) & lcdc_flag::lcd_enable) == 0)
 	{
 		access_register(r::stat) &= ~(stat_flag::mode | stat_flag::coincidence);
 		access_register(r::stat) |= mode::vblank;
-		_mode_time = cputime(9120 - 1);
+		_mode_time = vblank_time - cputime(1);
 		_hblanks = 0;
 		_vblank_ly_time = cputime(0);
 		return;
@@ -273,23 +460,23 @@ void gb::video::tick(gb::z80_cpu &cpu, cputime time)
 	switch (current_mode)
 	{
 	case mode::read_oam:
-		if (_mode_time > cputime(160))
+		if (_mode_time > read_oam_time)
 		{
-			_mode_time -= cputime(160);
+			_mode_time -= read_oam_time;
 			next_mode = mode::read_vram;
 		}
 		break;
 	case mode::read_vram:
-		if (_mode_time > cputime(344))
+		if (_mode_time > read_vram_time)
 		{
-			_mode_time -= cputime(344);
+			_mode_time -= read_vram_time;
 			next_mode = mode::hblank;
 		}
 		break;
 	case mode::hblank:
-		if (_mode_time > cputime(408))
+		if (_mode_time > hblank_time)
 		{
-			_mode_time -= cputime(408);
+			_mode_time -= hblank_time;
 			++_hblanks;
 			if (_hblanks == 144)
 			{
@@ -302,17 +489,17 @@ void gb::video::tick(gb::z80_cpu &cpu, cputime time)
 		}
 		break;
 	case mode::vblank:
-		if (_mode_time > cputime(9120))
+		if (_mode_time > vblank_time)
 		{
-			_mode_time -= cputime(9120);
+			_mode_time -= vblank_time;
 			next_mode = mode::read_oam;
 		}
 		else
 		{
 			_vblank_ly_time += time;
-			if (_vblank_ly_time > cputime(912))
+			if (_vblank_ly_time > vblank_line_time)
 			{
-				_vblank_ly_time -= cputime(912);
+				_vblank_ly_time -= vblank_line_time;
 				set_ly(cpu, access_register(r::ly) + 1);
 			}
 		}
@@ -331,6 +518,8 @@ void gb::video::tick(gb::z80_cpu &cpu, cputime time)
 			if (current_mode == mode::vblank)
 			{
 				_hblanks = 0;
+				_window_line = 0;
+				log({video_event::type::frame_start, 0, 0});
 				set_ly(cpu, 0);
 			}
 			else
@@ -345,7 +534,19 @@ void gb::video::tick(gb::z80_cpu &cpu, cputime time)
 			{
 				cpu.post_interrupt(interrupt::lcdc);
 			}
-			draw_line(access_register(r::ly));
+			if (_pipeline)
+			{
+				count_window_line(access_register(r::ly));
+				log({video_event::type::draw_line, _drawing, access_register(r::ly)});
+			}
+			else
+			{
+				draw_line(access_register(r::ly), count_window_line(access_register(r::ly)));
+			}
+			if (_hdma_active && _hdma_hblank)
+			{
+				hdma_transfer(cpu, 1);
+			}
 			break;
 		case mode::vblank:
 			if (bit::test(access_register(r::stat), stat_flag::vblank_int))
@@ -354,6 +555,15 @@ void gb::video::tick(gb::z80_cpu &cpu, cputime time)
 			}
 			cpu.post_interrupt(interrupt::vblank);
 			_vblank_ly_time = cputime(0);
+			++_frames;
+			if (_pipeline)
+			{
+				log({video_event::type::frame_end, _drawing, 0});
+			}
+			else if (_frame_complete && _drawing)
+			{
+				_frame_complete(_frame);
+			}
 			break;
 		}
 
@@ -362,106 +572,177 @@ void gb::video::tick(gb::z80_cpu &cpu, cputime time)
 	}
 }
 
-// Parses sprite data and returns the color index for the given (sprite local) pixel.
-static int draw_sprite(const uint8_t *sprite_data, int x, int y)
+gb::cputime gb::video::time_until_event(const z80_cpu &cpu) const
 {
-	ASSERT(sprite_data != nullptr);
-	ASSERT(0 <= x && x <= 7);
-	ASSERT(0 <= y && y <= 15);
+	if (_dma_starting || _check_ly || (_hdma_active && !_hdma_hblank))
+	{
+		return cputime(0);
+	}
 
-	const auto tile_line_index = y * 2;
-	const auto tile_x_bit = 7 - x;
-	auto color_idx = 0;
-	if ((sprite_data[tile_line_index] & (1 << tile_x_bit)) != 0)
-		color_idx |= 1;
-	if ((sprite_data[tile_line_index + 1] & (1 << tile_x_bit)) != 0)
-		color_idx |= 2;
+	auto until = cputime::max();
+	if (_dma_running)
+	{
+		until = std::max(dma_time / (cpu.double_speed() ? 2 : 1) - _dma_time_elapsed, cputime(0));
+	}
 
-	return color_idx;
+	if (!is_enabled())
+	{
+		return until;
+	}
+
+	// tick switches the mode as soon as the mode time is exceeded
+	switch (access_register(r::stat) & stat_flag::mode)
+	{
+	case mode::read_oam:
+		return std::min(until, read_oam_time - _mode_time + cputime(1));
+	case mode::read_vram:
+		return std::min(until, read_vram_time - _mode_time + cputime(1));
+	case mode::hblank:
+		return std::min(until, hblank_time - _mode_time + cputime(1));
+	default:  // mode::vblank, the mode has only two bits
+		until = std::min(until, vblank_time - _mode_time + cputime(1));
+		return std::min(until, vblank_line_time - _vblank_ly_time + cputime(1));
+	}
 }
 
-void gb::video::draw_line(const int y)
+gb::cputime gb::video::take_cpu_stall()
 {
-	// debug("DRAWING line ", y);
-	const int scy = access_register(r::scy);
-	const int scx = access_register(r::scx);
-	const auto lcdc = access_register(r::lcdc);
+	const auto stall = _cpu_stall;
+	_cpu_stall = cputime(0);
+	return stall;
+}
 
-	// TODO LCDC bit 0
-	const bool bg_normal_priority = bit::test(lcdc, lcdc_flag::bg_display);
-	if (!bg_normal_priority) debug("NIP: LCDC bit 0 is 0");
+void gb::video::hdma_transfer(z80_cpu &cpu, int blocks)
+{
+	ASSERT(_hdma_active);
+	ASSERT(0 < blocks && blocks <= _hdma_blocks);
 
-	const uint8_t *bg_tile_map;
-	const uint8_t *bg_tile_map_attrs;
-	if (bit::test(lcdc, lcdc_flag::bg_tile_map_select))
+	// Copied in runs which neither cross a source page nor the end of VRAM.
+	int length = blocks * 0x10;
+	while (length > 0 && _hdma_dest < 0x2000)
 	{
-		bg_tile_map = &_vram[0][0x9C00 - 0x8000];
-		bg_tile_map_attrs = &_vram[1][0x9C00 - 0x8000];
+		const int run = std::min({length, 0x100 - (_hdma_source & 0xFF), 0x2000 - _hdma_dest});
+		uint8_t *dest = &_vram[_vram_bank][_hdma_dest];
+		if (const uint8_t *page = cpu.memory().read_page(_hdma_source))
+		{
+			std::copy_n(page + (_hdma_source & 0xFF), run, dest);
+		}
+		else
+		{
+			debug("WARNING: HDMA from ", _hdma_source, " which is no plain memory");
+			for (int i = 0; i < run; ++i)
+				dest[i] = cpu.memory().read8(static_cast<uint16_t>(_hdma_source + i));
+		}
+		_vram_dirty.mark(_vram_bank * 0x2000 + _hdma_dest, run);
+		if (_pipeline)
+		{
+			for (int i = 0; i < run; ++i)
+				log({video_event::type::vram, dest[i], static_cast<uint16_t>(_vram_bank * 0x2000 + _hdma_dest + i)});
+		}
+		else
+		{
+			for (int offset = _hdma_dest; offset < std::min(_hdma_dest + run, tile_count * 16); offset += 2)
+				decode_tile_row(_vram_bank, offset);
+		}
+		_hdma_source += run;
+		_hdma_dest += run;
+		length -= run;
+	}
+
+	_cpu_stall += blocks * hdma_block_time;
+	_hdma_blocks -= blocks;
+	if (_hdma_blocks == 0 || _hdma_dest >= 0x2000)
+	{
+		_hdma_active = false;
+		access_register(r::hdma5) = 0xFF;
 	}
 	else
 	{
-		bg_tile_map = &_vram[0][0x9800 - 0x8000];
-		bg_tile_map_attrs = &_vram[1][0x9800 - 0x8000];
+		access_register(r::hdma5) = static_cast<uint8_t>(_hdma_blocks - 1);
 	}
+}
 
-	const bool window_enabled = bit::test(lcdc, lcdc_flag::window_display_enable);
-	if (window_enabled) debug("NIP: window display not implemented");
+namespace
+{
+
+// Writes the packed pixels of every step-th color index, Size bytes each
+template <size_t Size>
+void convert_line(const uint8_t *indices, int step, int count, const std::array<uint32_t, 64> &pixels, uint8_t *out)
+{
+	for (int x = 0; x < count; ++x)
+		std::memcpy(out + x * Size, &pixels[indices[x * step]], Size);
+}
+
+}
+
+bool gb::video::window_visible(int y) const
+{
+	return bit::test(access_register(r::lcdc), lcdc_flag::window_display_enable)
+		&& y >= access_register(r::wy) && access_register(r::wx) - 7 < width;
+}
+
+int gb::video::count_window_line(int y)
+{
+	// The window has its own line counter, which only counts the lines it is shown on
+	const int window_line = _window_line;
+	if (window_visible(y))
+		++_window_line;
+	return window_line;
+}
+
+void gb::video::draw_line(const int y, const int window_line)
+{
+	const profiler::scope scope(profiler::subsystem::draw);
+	// debug("DRAWING line ", y);
+	if (!_drawing)
+		return;
+	const auto lcdc = access_register(r::lcdc);
+	const int window_x = access_register(r::wx) - 7;
+	const bool window_shown = window_visible(y);
+
+	const int view_y = y - _view.top;
+	if (view_y < 0 || view_y >= _view.height)
+		return;
+	if (view_y % _view.scale != 0 && _frame.format != pixel_format::gray8)
+		return;  // only the first line of a block is shown
+	const int scy = access_register(r::scy);
+	const int scx = access_register(r::scx);
+
+	// TODO LCDC bit 0
+	const bool bg_normal_priority = bit::test(lcdc, lcdc_flag::bg_display);
+	if (!bg_normal_priority) debug("NIP: LCDC bit 0 is 0");
+
+	const uint16_t bg_tile_map = bit::test(lcdc, lcdc_flag::bg_tile_map_select) ? 0x9C00 : 0x9800;
+	const uint16_t window_tile_map = bit::test(lcdc, lcdc_flag::window_tile_map_display_select) ? 0x9C00 : 0x9800;
 
 	const bool sprite_enabled = bit::test(lcdc, lcdc_flag::obj_display_enable);
 	const auto sprite_size_x = 8;
 	const auto sprite_size_y = bit::test(lcdc, lcdc_flag::obj_size) ? 16 : 8;
 
-	// Used by sprites drawing to have correct z-ordering (no overdraw if the bit is true)
-	// but it must be accessible by the BG-drawing because of the OBJ-to-BG priority flag.
-	std::bitset<video::width> pixel_done;
+	// The layers are drawn separately as pixel bytes (see compose_line) and merged at the end.
+	std::array<uint8_t, width> bg_line;
+	std::array<uint8_t, width> obj_line;
+	std::array<uint8_t, width> line;
 
-	for (int x = 0; x < width; ++x)
+	// Background, covered by the window from its left edge to the end of the line
+	draw_tiles(bg_tile_map, (y + scy) % 256, scx, bg_line.data(), width);
+	if (window_shown)
 	{
-		// Reset
-		image(x, y) = {255, 255, 255};
-
-		// Background
-		{
-			const auto map_index = (((y + scy) / 8) % 32) * 32 + ((x + scx) / 8) % 32;
-			//                        ^^^^^^^ screen y + scroll offset
-			//                                   ^ position in px -> slot number (256 -> 32)
-			//                                        ^^ wrap around
-			//                                              ^^ actual memory location (row/x major layout)
-
-			const auto tile_attrs = bg_tile_map_attrs[map_index];
-			const auto bgp_idx = tile_attrs & 0x07;
-			const auto tile_vram_bank = bit::test(tile_attrs, 1 << 3) ? 1 : 0;
-			const auto hflip = bit::test(tile_attrs, 1 << 5);
-			const auto vflip = bit::test(tile_attrs, 1 << 6);
-			const auto priority = bit::test(tile_attrs, 1 << 7);
-
-			const auto tile_idx = bg_tile_map[map_index];
-			const auto tile_data = get_bg_tile(tile_vram_bank, tile_idx);
-
-			if (hflip) debug("NIP: hflip at ", x, " ", y);
-			if (vflip) debug("NIP: vflip at ", x, " ", y);
-			// TODO hflip
-			// TODO vflip
-
-			const auto color_idx = draw_sprite(tile_data, (x + scx) % 8, (y + scy) % 8);
-			if (priority && color_idx != 0)
-			{
-				// even if there is priority set, BG color 0 is always behind the object
-				pixel_done[x] = true;
-			}
-			image(x, y) = get_color(bgp_idx, color_idx, true);
-		}
+		const auto start = std::max(window_x, 0);
+		draw_tiles(window_tile_map, window_line, start - window_x, &bg_line[start], width - start);
 	}
 
-	// Objects/Sprites
+	// Objects/Sprites, the first one in OAM with a non transparent pixel wins
+	std::fill(obj_line.begin(), obj_line.end(), 0);
 	if (sprite_enabled) {
-		int drawn_count = 0;
-		for (int i = 0; i < 40 && drawn_count < 10; ++i)
+		if (!_sprite_lines_valid || _sprite_lines_height != sprite_size_y)
+			update_sprite_lines(sprite_size_y);
+
+		const auto &sprites = _sprite_lines[y];
+		for (int n = 0; n < sprites.count; ++n)
 		{
+			const auto i = sprites.sprites[n];
 			const auto sprite_y = _sprite_attribs[i * 4] - 16;
-			if (!(sprite_y <= y && y < sprite_y + sprite_size_y))
-				continue;
-			++drawn_count;
 
 			const auto sprite_attrs = _sprite_attribs[i * 4 + 3];
 			const auto palette_idx = sprite_attrs & 0x7;
@@ -469,36 +750,90 @@ void gb::video::draw_line(const int y)
 			// bit 4 only relevant in DMG mode
 			const auto x_flip = bit::test(sprite_attrs, 1 << 5);
 			const auto y_flip = bit::test(sprite_attrs, 1 << 6);
-			const auto behind_bg = bit::test(sprite_attrs, 1 << 7);
-
-			if (x_flip) debug("NIP: sprite x-flip");  // TODO
-			if (y_flip) debug("NIP: sprite y-flip");  // TODO
-			if (behind_bg) debug("NIP: sprite behind bg color 1-3");  // TODO
+			const auto behind_bg = sprite_attrs & 0x80;
 
 			auto tile_idx = _sprite_attribs[i * 4 + 2];
 			if (sprite_size_y == 16)
 				tile_idx &= 0xFE;
-			const auto tile_data = &_vram[vram_bank][tile_idx * 16];
-
-			const auto sprite_local_y = y - sprite_y;
+			// a y flipped 8x16 sprite also swaps its tiles
+			auto sprite_local_y = y - sprite_y;
+			if (y_flip)
+				sprite_local_y = sprite_size_y - 1 - sprite_local_y;
+			const auto row = tile_row(vram_bank, tile_idx + sprite_local_y / 8, sprite_local_y % 8, x_flip);
 			const auto sprite_x = _sprite_attribs[i * 4 + 1] - 8;
-			for (auto x = sprite_x; x < sprite_x + sprite_size_x; ++x)
+			const auto pixel = static_cast<uint8_t>(behind_bg | palette_idx << 2);
+			for (auto x = std::max(sprite_x, 0); x < std::min(sprite_x + sprite_size_x, static_cast<int>(width)); ++x)
 			{
-				if (x < 0 || x >= video::width)
-					continue;
-				if (pixel_done[x])
-					continue;
-
-				const auto sprite_local_x = x - sprite_x;
-				const auto color_index = draw_sprite(tile_data, sprite_local_x, sprite_local_y);
-				if (color_index != 0)  // 0 is always transparent
-				{
-					pixel_done[x] = true;
-					image(x, y) = get_color(palette_idx, color_index, false);
-				}
+				const auto color_index = row[x - sprite_x];
+				if (color_index != 0 && obj_line[x] == 0)  // 0 is always transparent
+					obj_line[x] = pixel | color_index;
 			}
 		}
 	}
+
+	compose_line(_simd, bg_line.data(), obj_line.data(), line.data(), width);
+	write_line(y, line);
+}
+
+void gb::video::write_line(int y, const std::array<uint8_t, width> &line)
+{
+	const int view_y = y - _view.top;
+	const int scale = _view.scale;
+	const auto count = _view.frame_width();
+	const auto *indices = &line[_view.left];
+	auto *out = _frame.line(view_y / scale);
+
+	if (scale > 1 && _frame.format == pixel_format::gray8)
+	{
+		// the block sums are collected over its lines
+		if (view_y % scale == 0)
+			std::fill(_gray_sums.begin(), _gray_sums.end(), 0);
+		for (int x = 0; x < count; ++x)
+			for (int i = 0; i < scale; ++i)
+				_gray_sums[x] += _pixels[indices[x * scale + i]];
+		if (view_y % scale == scale - 1)
+			for (int x = 0; x < count; ++x)
+				out[x] = static_cast<uint8_t>(_gray_sums[x] / (scale * scale));
+		return;
+	}
+
+	switch (_frame.format)
+	{
+	case pixel_format::rgb888:
+		convert_line<3>(indices, scale, count, _pixels, out);
+		break;
+	case pixel_format::rgba8888:
+		convert_line<4>(indices, scale, count, _pixels, out);
+		break;
+	case pixel_format::rgb565:
+		convert_line<2>(indices, scale, count, _pixels, out);
+		break;
+	case pixel_format::indexed:
+	case pixel_format::gray8:
+		convert_line<1>(indices, scale, count, _pixels, out);
+		break;
+	}
+}
+
+void gb::video::update_sprite_lines(int sprite_height)
+{
+	// Each line has the first 10 sprites in OAM order which overlap it
+	for (auto &line : _sprite_lines)
+		line.count = 0;
+
+	for (uint8_t i = 0; i < 40; ++i)
+	{
+		const auto sprite_y = _sprite_attribs[i * 4] - 16;
+		for (int y = std::max(sprite_y, 0); y < std::min(sprite_y + sprite_height, static_cast<int>(height)); ++y)
+		{
+			auto &line = _sprite_lines[y];
+			if (line.count < max_line_sprites)
+				line.sprites[line.count++] = i;
+		}
+	}
+
+	_sprite_lines_valid = true;
+	_sprite_lines_height = sprite_height;
 }
 
 void gb::video::set_ly(z80_cpu &cpu, uint8_t value)
@@ -518,15 +853,72 @@ void gb::video::set_ly(z80_cpu &cpu, uint8_t value)
 	}
 }
 
-const uint8_t *gb::video::get_bg_tile(uint8_t bank, uint8_t idx) const
+void gb::video::draw_tiles(uint16_t map_addr, int map_y, int map_x, uint8_t *out, int count) const
 {
+	const auto map_offset = map_addr - 0x8000 + (map_y / 8) * 32;
+	const auto *tiles = &_vram[0][map_offset];
+	const auto *attrs = &_vram[1][map_offset];
+
+	// one span per tile, only the first and the last one can be partial
+	for (int x = 0; x < count;)
+	{
+		const auto column = (map_x + x) / 8 % 32;
+		const auto tile_attrs = attrs[column];
+		const auto bgp_idx = tile_attrs & 0x07;
+		const auto tile_vram_bank = bit::test(tile_attrs, 1 << 3) ? 1 : 0;
+		const auto hflip = bit::test(tile_attrs, 1 << 5);
+		const auto vflip = bit::test(tile_attrs, 1 << 6);
+		const auto priority = tile_attrs & 0x80;
+
+		const auto tile_y = vflip ? 7 - map_y % 8 : map_y % 8;
+		const auto *row = tile_row(tile_vram_bank, bg_tile(tiles[column]), tile_y, hflip);
+		const auto pixel = static_cast<uint8_t>(priority | bgp_idx << 2);
+		const auto first = (map_x + x) % 8;
+		const auto span = std::min(8 - first, count - x);
+		for (int i = 0; i < span; ++i)
+			out[x + i] = pixel | row[first + i];
+		x += span;
+	}
+}
+
+int gb::video::bg_tile(uint8_t idx) const
+{
+	// 8000-8FFF with unsigned or 9000 +/- 800 with signed indices
 	if (bit::test(access_register(r::lcdc), lcdc_flag::bg_window_data_select))
 	{
-		return &_vram[bank][idx * 16];
+		return idx;
 	}
 	else
 	{
-		return &_vram[bank][0x1000 + static_cast<int8_t>(idx) * 16];
+		return 256 + static_cast<int8_t>(idx);
+	}
+}
+
+void gb::video::decode_tiles()
+{
+	for (int bank = 0; bank < 2; ++bank)
+		for (int offset = 0; offset < tile_count * 16; offset += 2)
+			decode_tile_row(bank, offset);
+}
+
+void gb::video::decode_tile_row(int bank, int offset)
+{
+	ASSERT(0 <= offset && offset < tile_count * 16);
+
+	// A row is 2 bytes, the first has the low bits of the color indices
+	offset &= ~1;
+	const uint8_t low = _vram[bank][offset];
+	const uint8_t high = _vram[bank][offset + 1];
+	const auto tile = bank * tile_count + offset / 16;
+	const auto row = (offset % 16) / 2;
+
+	uint8_t *pixels = &_tiles[0][tile][row * 8];
+	uint8_t *flipped = &_tiles[1][tile][row * 8];
+	for (int x = 0; x < 8; ++x)
+	{
+		const auto bit = 7 - x;
+		pixels[x] = static_cast<uint8_t>(((low >> bit) & 1) | (((high >> bit) & 1) << 1));
+		flipped[7 - x] = pixels[x];
 	}
 }
 
@@ -549,3 +941,212 @@ std::array<uint8_t, 3> gb::video::get_color(size_t pal_idx, size_t color_idx, bo
 	return {static_cast<uint8_t>(r * 255), static_cast<uint8_t>(g * 255), static_cast<uint8_t>(b * 255)};
 }
 
+
+void gb::video::update_color(int entry, bool bg)
+{
+	const auto index = (bg ? 0 : 32) + entry;
+	_colors[index] = get_color(entry / 4, entry % 4, bg);
+	_pixels[index] = pack_pixel(_frame.format, _colors[index], static_cast<uint8_t>(index));
+}
+
+void gb::video::set_pixel_format(pixel_format format, size_t stride)
+{
+	if (_pipeline)
+	{
+		sync();
+		_renderer->set_pixel_format(format, stride);
+		_frame = _renderer->_frame;
+		update_pixels();
+		return;
+	}
+
+	const auto size = pixel_size(format);
+	const auto frame_width = static_cast<size_t>(_view.frame_width());
+	if (stride == 0)
+		stride = frame_width * size;
+	ASSERT(stride >= frame_width * size);
+
+	_frame_storage.assign(stride * _view.frame_height(), 0);
+	_frame = {_frame_storage.data(), stride, format};
+	update_pixels();
+
+	// white until the first frame is drawn
+	const auto white = pack_pixel(format, {{255, 255, 255}}, 0);
+	for (int y = 0; y < _view.frame_height(); ++y)
+		for (size_t x = 0; x < frame_width; ++x)
+			std::memcpy(_frame.line(y) + x * size, &white, size);
+}
+
+void gb::video::attach_framebuffer(const framebuffer &buffer)
+{
+	if (_pipeline)
+	{
+		sync();
+		_renderer->attach_framebuffer(buffer);
+		_frame = _renderer->_frame;
+		update_pixels();
+		return;
+	}
+
+	if (buffer.data == nullptr)
+	{
+		set_pixel_format(buffer.format, buffer.stride);
+		return;
+	}
+	ASSERT(buffer.stride >= _view.frame_width() * pixel_size(buffer.format));
+
+	_frame_storage.clear();
+	_frame_storage.shrink_to_fit();
+	_frame = buffer;
+	update_pixels();
+}
+
+void gb::video::update_pixels()
+{
+	for (size_t i = 0; i < _colors.size(); ++i)
+		_pixels[i] = pack_pixel(_frame.format, _colors[i], static_cast<uint8_t>(i));
+}
+
+void gb::video::set_view(const frame_view &view)
+{
+	ASSERT(view.scale >= 1 && view.width % view.scale == 0 && view.height % view.scale == 0);
+	ASSERT(view.left >= 0 && view.width > 0 && view.left + view.width <= width);
+	ASSERT(view.top >= 0 && view.height > 0 && view.top + view.height <= height);
+
+	_view = view;
+	if (_pipeline)
+	{
+		sync();
+		_renderer->set_view(view);
+		_frame = _renderer->_frame;
+	}
+	else if (!_frame_storage.empty())
+	{
+		set_pixel_format(_frame.format);
+	}
+	else
+	{
+		ASSERT(_frame.stride >= _view.frame_width() * pixel_size(_frame.format));
+	}
+}
+
+void gb::video::on_frame_complete(frame_callback callback)
+{
+	if (_pipeline)
+	{
+		sync();
+		_renderer->_frame_complete = std::move(callback);
+	}
+	else
+	{
+		_frame_complete = std::move(callback);
+	}
+}
+
+void gb::video::set_pipelined(bool pipelined)
+{
+	if (pipelined == (_pipeline != nullptr))
+	{
+		return;
+	}
+
+	if (pipelined)
+	{
+		_renderer = std::make_unique<video>();
+		copy_to_renderer();
+		move_drawing_state(*_renderer);
+		_pipeline = std::make_unique<video_pipeline>(*_renderer);
+	}
+	else
+	{
+		_pipeline.reset();  // draws the rest
+		_renderer->move_drawing_state(*this);
+		_renderer.reset();
+	}
+}
+
+void gb::video::sync()
+{
+	if (_pipeline)
+	{
+		_pipeline->sync();
+	}
+}
+
+void gb::video::log(const video_event &event)
+{
+	if (_pipeline)
+	{
+		_pipeline->push(event);
+	}
+}
+
+void gb::video::replay(const video_event &event)
+{
+	switch (event.what)
+	{
+	case video_event::type::vram:
+	{
+		const auto bank = event.addr / 0x2000;
+		const auto offset = event.addr % 0x2000;
+		_vram[bank][offset] = event.value;
+		if (offset < tile_count * 16)
+			decode_tile_row(bank, offset);
+		break;
+	}
+	case video_event::type::oam:
+		_sprite_attribs[event.addr] = event.value;
+		_sprite_lines_valid = false;
+		break;
+	case video_event::type::reg:
+		access_register(event.addr) = event.value;
+		break;
+	case video_event::type::bg_palette:
+		_bgp[event.addr] = event.value;
+		update_color(event.addr / 2, true);
+		break;
+	case video_event::type::obj_palette:
+		_obp[event.addr] = event.value;
+		update_color(event.addr / 2, false);
+		break;
+	case video_event::type::draw_line:
+		_drawing = event.value != 0;
+		draw_line(event.addr, count_window_line(event.addr));
+		break;
+	case video_event::type::frame_start:
+		_window_line = 0;
+		break;
+	case video_event::type::frame_end:
+		++_frames;
+		if (_frame_complete && event.value != 0)
+			_frame_complete(_frame);
+		break;
+	}
+}
+
+void gb::video::copy_to_renderer()
+{
+	_renderer->_registers = _registers;
+	_renderer->_vram = _vram;
+	_renderer->_sprite_attribs = _sprite_attribs;
+	_renderer->_bgp = _bgp;
+	_renderer->_obp = _obp;
+	_renderer->_colors = _colors;
+	_renderer->_frames = _frames;
+	_renderer->_window_line = _window_line;
+	_renderer->_sprite_lines_valid = false;
+}
+
+void gb::video::move_drawing_state(video &to)
+{
+	// the rest is kept up to date by the video which runs the emulation
+	to._tiles = _tiles;
+	to._pixels = _pixels;
+	to._window_line = _window_line;
+	to._view = _view;
+	to._frame_storage = std::move(_frame_storage);  // keeps the data pointer
+	to._frame = _frame;
+	to._frame_complete = std::move(_frame_complete);
+	to._sprite_lines_valid = false;
+	_frame_storage.clear();
+}
@@ -1,12 +1,20 @@
 #pragma once
 #include "memory.hpp"
 #include "time.hpp"
+#include "state_hash.hpp"
+#include "compositor.hpp"
+#include "framebuffer.hpp"
 #include <array>
+#include <functional>
+#include <memory>
+#include <vector>
 
 namespace gb
 {
 
 class z80_cpu;
+class video_pipeline;
+struct video_event;
 
 class video final : public memory_mapping
 {
@@ -14,8 +22,12 @@ public:
 	static const int width = 160;
 	static const int height = 144;
 	static const cputime dma_time;
-	using raw_image = std::array<std::array<std::array<uint8_t, 3>, width>, height>;
-	static_assert(sizeof(raw_image) == 3 * width * height, "raw_image has the wrong size");
+	/** The CPU is stalled for this time for every 16 byte block of a HDMA/GDMA transfer. */
+	static const cputime hdma_block_time;
+	/** Tiles in 8000-97FF of each VRAM bank. */
+	static const int tile_count = 384;
+	/** RGB of the 64 colors, background palettes (0-31) and then sprite palettes (32-63). */
+	using color_table = std::array<std::array<uint8_t, 3>, 64>;
 
 	// Register memory addresses:
 	//   FF40 to FF4B
@@ -101,43 +113,153 @@ public:
 	};
 
 	video();
+	~video();
 
 	bool read8(uint16_t addr, uint8_t &value) const override;
 	bool write8(uint16_t addr, uint8_t value) override;
+	bool read_page(uint16_t addr, const uint8_t *&page) const override;
+	uint64_t state_hash(uint64_t seed) override;
+	/** The state doesn't include the frame, which is output. */
+	void save_state(state_writer &state) const override;
+	void load_state(state_reader &state) override;
 
 	void tick(z80_cpu &cpu, cputime time);
+	/** Time until tick changes the mode or LY (or finishes a DMA transfer). */
+	cputime time_until_event(const z80_cpu &cpu) const;
+	/** Returns and resets the time the CPU is stalled by HDMA/GDMA transfers. */
+	cputime take_cpu_stall();
 
 	bool is_enabled() const { return (access_register(r::lcdc) & lcdc_flag::lcd_enable) != 0; }
-	const raw_image &image() const { return _image; }
+	using frame_callback = std::function<void (const framebuffer &frame)>;
+
+	/**
+	 * Renders only a part of the screen, optionally shrunk (the whole screen by default).
+	 * An own frame is allocated again with packed lines, an attached one has to fit.
+	 */
+	void set_view(const frame_view &view);
+	const frame_view &view() const { return _view; }
+	/** Renders into a new frame in the given format, stride 0 for packed lines. */
+	void set_pixel_format(pixel_format format, size_t stride = 0);
+	/**
+	 * Renders the lines straight into a buffer of the caller (frame_height of the view lines) that
+	 * has to stay valid until the next attach or set_pixel_format. Its contents are only changed by
+	 * drawn lines. A null data pointer goes back to an own frame with that format.
+	 */
+	void attach_framebuffer(const framebuffer &buffer);
+	/** Called at the start of vblank with the drawn frame, on the thread that draws. */
+	void on_frame_complete(frame_callback callback);
+	/** The frame being drawn, complete at the start of vblank. */
+	const framebuffer &frame() const { return _frame; }
+	/** The colors of the indices of pixel_format::indexed. */
+	const color_table &palette() const { return _colors; }
+	/**
+	 * Draws the lines on another thread one step behind (see video_pipeline), the timing of
+	 * STAT, LY and the interrupts stays on the calling thread. The frame is written and the
+	 * frame complete callback is called on the other thread, call sync before reading it.
+	 */
+	void set_pipelined(bool pipelined);
+	bool pipelined() const { return _pipeline != nullptr; }
+	/** Waits until all lines so far are drawn, if pipelined. */
+	void sync();
+	/** Applies an event on the thread of a pipeline. */
+	void replay(const video_event &event);
+	/** Skips drawing the lines (e.g. for hidden frames), the rest runs the same. */
+	void set_drawing(bool drawing) { _drawing = drawing; }
+	/** Number of vblanks since power on. */
+	uint64_t frames() const { return _frames; }
+	/** Written pages of the VRAM (bank 1 at 2000). */
+	dirty_pages &vram_dirty() { return _vram_dirty; }
 
 private:
 	static bool is_register(uint16_t addr);
 	uint8_t &access_register(uint16_t addr);
 	const uint8_t &access_register(uint16_t addr) const;
-	void draw_line(const int line);
+	bool window_visible(int y) const;
+	/** Counts a line in _window_line, returns the window line shown on line y. */
+	int count_window_line(int y);
+	void draw_line(const int line, const int window_line);
+	/** Draws count pixels (see compose_line) of a line of a 256 * 256 tile map from map_x on. */
+	void draw_tiles(uint16_t map_addr, int map_y, int map_x, uint8_t *out, int count) const;
+	/** Converts the color indices of a line into the frame. */
+	void write_line(int y, const std::array<uint8_t, width> &line);
+	void update_sprite_lines(int sprite_height);
 	void set_ly(z80_cpu &cpu, uint8_t value);
-	std::array<uint8_t, 3> &image(int x, int y) { return _image[y][x]; }
-	const uint8_t *get_bg_tile(uint8_t bank, uint8_t idx) const;
+	void hdma_transfer(z80_cpu &cpu, int blocks);
+	int bg_tile(uint8_t idx) const;
+	void decode_tiles();
+	void decode_tile_row(int bank, int offset);
+	/** Color indices of 8 pixels of a tile, hflip gives the mirrored row. */
+	const uint8_t *tile_row(int bank, int tile, int row, bool hflip = false) const
+	{
+		return &_tiles[hflip][bank * tile_count + tile][row * 8];
+	}
 	std::array<uint8_t, 3> get_color(size_t bgp_idx, size_t color_idx, bool bg) const;
+	/** Queues an event for the pipeline, if pipelined. */
+	void log(const video_event &event);
+	/** Copies the memory and registers to the renderer, which must be idle (see sync). */
+	void copy_to_renderer();
+	/** Hands the frame and the state only needed for drawing over to another video. */
+	void move_drawing_state(video &to);
+	/** Packs all _colors for the format of _frame. */
+	void update_pixels();
+	/** Converts a changed palette entry (palette * 4 + color) into _colors. */
+	void update_color(int entry, bool bg);
 
 	std::array<uint8_t, 0x30> _registers;
 	std::array<std::array<uint8_t, 0x2000>, 2> _vram;
+	// The tile data decoded to one color index per pixel, updated on every write
+	using decoded_tile = std::array<uint8_t, 64>;
+	std::array<std::array<decoded_tile, 2 * tile_count>, 2> _tiles;  // [hflip][bank * tile_count + tile]
+	dirty_pages _vram_dirty;
+	page_hashes _vram_hashes;
 	std::array<uint8_t, 0xA0> _sprite_attribs;
+
+	// Sprites of every line, rebuilt on the next draw after OAM or the sprite height changed
+	static const int max_line_sprites = 10;
+	struct line_sprites
+	{
+		uint8_t count;
+		std::array<uint8_t, max_line_sprites> sprites;  // OAM index
+	};
+	std::array<line_sprites, height> _sprite_lines;
+	bool _sprite_lines_valid;
+	int _sprite_lines_height;
 	bool _check_ly;
 
 	std::array<uint8_t, 0x40> _bgp;  // background palette (8 times 4 colors times 2 byte)
 	std::array<uint8_t, 0x40> _obp;  // object/sprite palette (8 times 4 colors times 2 byte)
+	color_table _colors;  // indexed like compose_line
+	std::array<uint32_t, 64> _pixels;  // _colors packed for the frame format
 
 	int _vram_bank;
 
-	raw_image _image;
+	frame_view _view;
+	std::array<uint32_t, width> _gray_sums;  // of the block line in gray8 with a scale
+	std::vector<uint8_t> _frame_storage;
+	framebuffer _frame;  // _frame_storage or attached
+	frame_callback _frame_complete;
 	cputime _mode_time;
 	cputime _vblank_ly_time;
 	int _hblanks;
+	uint64_t _frames;
+	int _window_line;  // the line of the window, counts the lines it was drawn on this frame
+	bool _drawing;
 
 	bool _dma_starting;
 	bool _dma_running;
 	cputime _dma_time_elapsed;
+
+	bool _hdma_active;
+	bool _hdma_hblank;  // one block per hblank instead of everything at once (general purpose DMA)
+	int _hdma_blocks;   // remaining 16 byte blocks
+	uint16_t _hdma_source;
+	uint16_t _hdma_dest;  // offset in VRAM
+	cputime _cpu_stall;
+
+	simd _simd;
+
+	std::unique_ptr<video> _renderer;  // draws the lines if pipelined
+	std::unique_ptr<video_pipeline> _pipeline;
 };
 
 }
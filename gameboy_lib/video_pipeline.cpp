@@ -0,0 +1,82 @@
+#include "video_pipeline.hpp"
+#include "video.hpp"
+#include <chrono>
+
+gb::video_pipeline::video_pipeline(video &renderer) :
+	_renderer(renderer),
+	_batch_size(0),
+	_sent(0),
+	_replayed(0),
+	_stop(false)
+{
+	_thread = std::thread(&video_pipeline::run, this);
+}
+
+gb::video_pipeline::~video_pipeline()
+{
+	send();
+	_stop.store(true, std::memory_order_release);
+	_thread.join();
+}
+
+void gb::video_pipeline::sync()
+{
+	send();
+	while (_replayed.load(std::memory_order_acquire) != _sent)
+	{
+		std::this_thread::yield();
+	}
+}
+
+void gb::video_pipeline::send()
+{
+	// waits for the thread if the buffer is full, that is more than a frame behind
+	size_t done = 0;
+	while (done < _batch_size)
+	{
+		const auto n = _events.push(&_batch[done], _batch_size - done);
+		if (n == 0)
+		{
+			std::this_thread::yield();
+		}
+		done += n;
+	}
+	_sent += _batch_size;
+	_batch_size = 0;
+}
+
+void gb::video_pipeline::run()
+{
+	// Spins for a while when idle since the next line is due within 110 us, then sleeps
+	// so that a paused emulation doesn't keep a core busy.
+	const int spins = 1000;
+	std::array<video_event, 256> events;
+	int idle = 0;
+	for (;;)
+	{
+		const auto n = _events.pop(events.data(), events.size());
+		if (n == 0)
+		{
+			if (_stop.load(std::memory_order_acquire) && _events.size() == 0)
+			{
+				break;
+			}
+			if (++idle < spins)
+			{
+				std::this_thread::yield();
+			}
+			else
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+			continue;
+		}
+
+		idle = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			_renderer.replay(events[i]);
+		}
+		_replayed.fetch_add(n, std::memory_order_release);
+	}
+}
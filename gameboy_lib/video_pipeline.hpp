@@ -0,0 +1,74 @@
+#pragma once
+#include "ring_buffer.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace gb
+{
+
+class video;
+
+/** A change of the state used for drawing, or a step of drawing, in emulation order. */
+struct video_event
+{
+	enum class type : uint8_t
+	{
+		vram,         // addr: bank * 0x2000 + offset
+		oam,          // addr: offset
+		reg,          // addr: the register
+		bg_palette,   // addr: index into the palette bytes
+		obj_palette,  // addr: index into the palette bytes
+		draw_line,    // addr: LY, value: drawing
+		frame_start,
+		frame_end,    // value: drawing
+	};
+
+	type what;
+	uint8_t value;
+	uint16_t addr;
+};
+
+/**
+ * Draws the lines of a video on another thread. The events go through a lock-free buffer and
+ * are replayed there onto the renderer, a second video which only that thread uses.
+ */
+class video_pipeline
+{
+public:
+	explicit video_pipeline(video &renderer);
+	/** Replays the remaining events before the thread ends. */
+	~video_pipeline();
+
+	video_pipeline(const video_pipeline &) = delete;
+	video_pipeline &operator=(const video_pipeline &) = delete;
+
+	/** Queues an event, the events are sent in batches which end with any drawing. */
+	void push(const video_event &event)
+	{
+		_batch[_batch_size++] = event;
+		if (_batch_size == _batch.size() || event.what >= video_event::type::draw_line)
+		{
+			send();
+		}
+	}
+	/** Waits until all events so far are replayed. */
+	void sync();
+
+private:
+	void send();
+	void run();
+
+	video &_renderer;
+	std::array<video_event, 64> _batch;
+	size_t _batch_size;
+	size_t _sent;
+	ring_buffer<video_event, 0x4000> _events;
+	std::atomic<size_t> _replayed;
+	std::atomic<bool> _stop;
+	std::thread _thread;
+};
+
+}
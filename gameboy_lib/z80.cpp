@@ -1,6 +1,7 @@
 #include "z80.hpp"
 #include "z80opcodes.hpp"
 #include "internal_ram.hpp"
+#include "profiler.hpp"
 #include "debug.hpp"
 #include "assert.hpp"
 #include <string>
@@ -59,8 +60,7 @@ std::string gb::to_string(register16 r)
 
 gb::register_file::register_file()
 {
-	_pc = _sp = _a = _c = _b = _e = _d = _l = _h = 0;
-	_flag_z = _flag_n = _flag_h = _flag_c = false;
+	_pc = _sp = _a = _c = _b = _e = _d = _l = _h = _f = 0;
 }
 
 void gb::register_file::debug_print() const
@@ -68,7 +68,7 @@ void gb::register_file::debug_print() const
 	char buffer[200];
 	sprintf(buffer,
 		"AF=%02x%02x  BC=%02x%02x  DE=%02x%02x  HL=%02x%02x  SP=%04x  PC=%04x  [%c%c%c%c]",
-		static_cast<int>(_a), static_cast<int>(read8<register8::f>()), static_cast<int>(_b), static_cast<int>(_c),
+		static_cast<int>(_a), static_cast<int>(_f), static_cast<int>(_b), static_cast<int>(_c),
 		static_cast<int>(_d), static_cast<int>(_e), static_cast<int>(_h), static_cast<int>(_l),
 		static_cast<int>(_sp), static_cast<int>(_pc), get<cpu_flag::z>() ? 'z' : ' ',
 		get<cpu_flag::n>() ? 'n' : ' ', get<cpu_flag::h>() ? 'h' : ' ',
@@ -87,13 +87,19 @@ gb::z80_cpu::z80_cpu(gb::memory_map memory, gb::register_file registers) :
 	_jumped(false),
 	_temp(0),
 	_double_speed(false),
-	_speed_switch(false)
+	_speed_switch(false),
+	_jumped_back(false),
+	_jump_pc(0),
+	_idle_candidate(0),
+	_idle_candidate_value(0)
 {
+	std::fill(_not_idle_loops.begin(), _not_idle_loops.end(), 0);
 	_memory.add_mapping(this);
 }
 
 gb::cputime gb::z80_cpu::fetch_decode_execute()
 {
+	const profiler::scope scope(profiler::subsystem::cpu);
 	ASSERT(_opcode == nullptr);
 
 	// interrupts
@@ -131,7 +137,8 @@ gb::cputime gb::z80_cpu::fetch_decode_execute()
 	}
 
 	// fetch
-	uint16_t pc = _registers.read16<register16::pc>();
+	const uint16_t opcode_pc = _registers.read16<register16::pc>();
+	uint16_t pc = opcode_pc;
 	uint8_t opcode = _memory.read8(pc++);
 	_opcode = &(opcode == 0xCB ? cb_opcodes[_memory.read8(pc++)] : opcodes[opcode]);
 
@@ -161,11 +168,19 @@ gb::cputime gb::z80_cpu::fetch_decode_execute()
 	// this is the reason why I have to read the opcode time before
 	// executing the opcode.
 	cputime time = _opcode->cycles * (_double_speed ? clock_fast : clock);
-	_opcode->base_code(*this);
+	if (_opcode->has_step(opcode::base))
+	{
+		_opcode->execute(*this, opcode::base);
+	}
 	if (_jumped)
 	{
 		_jumped = false;
 		time += _opcode->jump_cycles * (_double_speed ? clock_fast : clock);
+		if (_registers.read16<register16::pc>() <= opcode_pc)
+		{
+			_jumped_back = true;
+			_jump_pc = opcode_pc;
+		}
 	}
 
 	return time;
@@ -173,26 +188,28 @@ gb::cputime gb::z80_cpu::fetch_decode_execute()
 
 gb::cputime gb::z80_cpu::read()
 {
+	const profiler::scope scope(profiler::subsystem::cpu);
 	// opcode can be nullptr if the CPU got un-halted by an interrupt
-	if (_halted || _opcode == nullptr || _opcode->read_code == nullptr)
+	if (_halted || _opcode == nullptr || !_opcode->has_step(opcode::read))
 	{
 		return cputime(0);
 	}
 
-	_opcode->read_code(*this);
+	_opcode->execute(*this, opcode::read);
 	return cputime(_double_speed ? clock_fast : clock);
 }
 
 gb::cputime gb::z80_cpu::write()
 {
+	const profiler::scope scope(profiler::subsystem::cpu);
 	// opcode can be nullptr if the CPU got un-halted by an interrupt
-	if (_halted || _opcode == nullptr || _opcode->write_code == nullptr)
+	if (_halted || _opcode == nullptr || !_opcode->has_step(opcode::write))
 	{
 		_opcode = nullptr;
 		return cputime(0);
 	}
 
-	_opcode->write_code(*this);
+	_opcode->execute(*this, opcode::write);
 
 	_opcode = nullptr;
 	return cputime(_double_speed ? clock_fast : clock);
@@ -210,6 +227,154 @@ void gb::z80_cpu::post_interrupt(interrupt interrupt)
 	}
 }
 
+bool gb::z80_cpu::interrupt_pending() const
+{
+	return _ime && (_memory.read8(internal_ram::if_) & _memory.read8(internal_ram::ie)) != 0;
+}
+
+bool gb::z80_cpu::take_idle_loop(idle_loop &loop)
+{
+	if (!_jumped_back)
+	{
+		return false;
+	}
+	_jumped_back = false;
+
+	const uint16_t start = _registers.read16<register16::pc>();
+	const uint32_t key = static_cast<uint32_t>(start) << 16 | _jump_pc;
+	auto &not_idle = _not_idle_loops[start % _not_idle_loops.size()];
+	if (not_idle == key)
+	{
+		return false;
+	}
+
+	// Positive results are not cached, the code could have been changed (RAM, bank switch).
+	if (!decode_idle_loop(start, _jump_pc, loop))
+	{
+		not_idle = key;
+		return false;
+	}
+
+	// The register might have changed since it was read in the last iteration. The loop is
+	// only idle after a complete iteration in which the register kept its value.
+	const uint8_t value = loop.polled_addr == 0 ? 0 : _memory.read8(loop.polled_addr);
+	if (_idle_candidate != key || _idle_candidate_value != value)
+	{
+		_idle_candidate = key;
+		_idle_candidate_value = value;
+		return false;
+	}
+	return true;
+}
+
+bool gb::z80_cpu::decode_idle_loop(uint16_t start, uint16_t jump_pc, idle_loop &loop) const
+{
+	// Only loops which are completely defined by the value read at their start qualify, every
+	// iteration after the first one with the same value leaves the CPU in exactly the same state:
+	//   [LD A,(ff00h+$) | LD A,($)]  read a register which only changes with time
+	//   {CP $ | AND $ | OR $ | XOR $ | BIT n,A}  XOR only after the read, it toggles A otherwise
+	//   JR/JP [cc,]start
+	static const int max_length = 16;
+	if (jump_pc - start > max_length)
+	{
+		return false;
+	}
+
+	int clocks = 0;
+	auto add_time = [&clocks](const opcode &op) {
+		clocks += op.cycles + (op.has_step(opcode::read) ? 1 : 0) + (op.has_step(opcode::write) ? 1 : 0);
+	};
+
+	uint16_t pc = start;
+	loop.polled_addr = 0;
+	const uint8_t first = _memory.read8(pc);
+	if (first == 0xF0 || first == 0xFA)  // LD A,(ff00h+$)  LD A,($)
+	{
+		const uint16_t addr = first == 0xF0 ? 0xFF00 + _memory.read8(pc + 1) : _memory.read16(pc + 1);
+		const bool polling_allowed =
+			   (0xFF40 <= addr && addr <= 0xFF4B)  // video
+			|| (0xFF04 <= addr && addr <= 0xFF07)  // timer
+			|| addr == internal_ram::if_;
+		if (!polling_allowed)
+		{
+			return false;
+		}
+		loop.polled_addr = addr;
+		add_time(opcodes[first]);
+		pc += first == 0xF0 ? 2 : 3;
+	}
+
+	while (pc < jump_pc)
+	{
+		const uint8_t op = _memory.read8(pc);
+		switch (op)
+		{
+		case 0xEE:  // XOR $
+			if (loop.polled_addr == 0)
+			{
+				return false;
+			}
+			// fall through
+		case 0xFE:  // CP $
+		case 0xE6:  // AND $
+		case 0xF6:  // OR $
+			add_time(opcodes[op]);
+			pc += 2;
+			break;
+		case 0xCB:
+		{
+			const uint8_t cb = _memory.read8(pc + 1);
+			if ((cb & 0xC7) != 0x47)  // BIT n,A
+			{
+				return false;
+			}
+			add_time(cb_opcodes[cb]);
+			pc += 2;
+			break;
+		}
+		default:
+			return false;
+		}
+	}
+
+	if (pc != jump_pc)
+	{
+		return false;
+	}
+
+	const uint8_t jump = _memory.read8(pc);
+	switch (jump)
+	{
+	case 0x18:  // JR $
+	case 0x20:  // JR NZ,$
+	case 0x28:  // JR Z,$
+	case 0x30:  // JR NC,$
+	case 0x38:  // JR C,$
+		if (static_cast<uint16_t>(pc + 2 + static_cast<int8_t>(_memory.read8(pc + 1))) != start)
+		{
+			return false;
+		}
+		break;
+	case 0xC3:  // JP $
+	case 0xC2:  // JP NZ,$
+	case 0xCA:  // JP Z,$
+	case 0xD2:  // JP NC,$
+	case 0xDA:  // JP C,$
+		if (_memory.read16(pc + 1) != start)
+		{
+			return false;
+		}
+		break;
+	default:
+		return false;
+	}
+	add_time(opcodes[jump]);
+	clocks += opcodes[jump].jump_cycles;
+
+	loop.iteration_time = clocks * (_double_speed ? clock_fast : clock);
+	return true;
+}
+
 void gb::z80_cpu::stop()
 {
 	if (_speed_switch)
@@ -254,3 +419,26 @@ bool gb::z80_cpu::write8(uint16_t addr, uint8_t value)
 	}
 }
 
+void gb::z80_cpu::save_state(state_writer &state) const
+{
+	state.write(_registers);
+	state.write(_ime);
+	state.write(_halted);
+	state.write(_double_speed);
+	state.write(_speed_switch);
+	state.write(_memory.dma_mode());
+}
+
+void gb::z80_cpu::load_state(state_reader &state)
+{
+	state.read(_registers);
+	state.read(_ime);
+	state.read(_halted);
+	state.read(_double_speed);
+	state.read(_speed_switch);
+	bool dma;
+	state.read(dma);
+	_memory.set_dma_mode(dma);
+	_opcode = nullptr;
+	_jumped_back = false;
+}
@@ -6,6 +6,7 @@
 #include <vector>
 #include <cstdint>
 #include <memory>
+#include <array>
 
 namespace gb
 {
@@ -65,7 +66,7 @@ public:
 private:
 	uint16_t _pc, _sp;
 	uint8_t _a, _c, _b, _e, _d, _l, _h;
-	bool _flag_z, _flag_n, _flag_h, _flag_c;
+	uint8_t _f;  // flags packed like the F register, lower nibble always 0
 };
 
 template <> inline uint8_t register_file::read8<register8::a>() const { return _a; }
@@ -73,7 +74,7 @@ template <> inline uint8_t register_file::read8<register8::b>() const { return _
 template <> inline uint8_t register_file::read8<register8::c>() const { return _c; }
 template <> inline uint8_t register_file::read8<register8::d>() const { return _d; }
 template <> inline uint8_t register_file::read8<register8::e>() const { return _e; }
-template <> inline uint8_t register_file::read8<register8::f>() const { return _flag_z << 7 | _flag_n << 6 | _flag_h << 5 | _flag_c << 4; }
+template <> inline uint8_t register_file::read8<register8::f>() const { return _f; }
 template <> inline uint8_t register_file::read8<register8::h>() const { return _h; }
 template <> inline uint8_t register_file::read8<register8::l>() const { return _l; }
 
@@ -82,11 +83,11 @@ template <> inline void register_file::write8<register8::b>(uint8_t value) { _b
 template <> inline void register_file::write8<register8::c>(uint8_t value) { _c = value; }
 template <> inline void register_file::write8<register8::d>(uint8_t value) { _d = value; }
 template <> inline void register_file::write8<register8::e>(uint8_t value) { _e = value; }
-template <> inline void register_file::write8<register8::f>(uint8_t value) { _flag_z = bit::test(value, 0x80); _flag_n = bit::test(value, 0x40); _flag_h = bit::test(value, 0x20); _flag_c = bit::test(value, 0x10);  }
+template <> inline void register_file::write8<register8::f>(uint8_t value) { _f = value & 0xF0; }
 template <> inline void register_file::write8<register8::h>(uint8_t value) { _h = value; }
 template <> inline void register_file::write8<register8::l>(uint8_t value) { _l = value; }
 
-template <> inline uint16_t register_file::read16<register16::af>() const { return _a << 8 | read8<register8::f>(); }
+template <> inline uint16_t register_file::read16<register16::af>() const { return _a << 8 | _f; }
 template <> inline uint16_t register_file::read16<register16::bc>() const { return _b << 8 | _c; }
 template <> inline uint16_t register_file::read16<register16::de>() const { return _d << 8 | _e; }
 template <> inline uint16_t register_file::read16<register16::hl>() const { return _h << 8 | _l; }
@@ -100,15 +101,8 @@ template <> inline void register_file::write16<register16::hl>(uint16_t value) {
 template <> inline void register_file::write16<register16::sp>(uint16_t value) { _sp = value; }
 template <> inline void register_file::write16<register16::pc>(uint16_t value) { _pc = value; }
 
-template <> inline bool register_file::get<cpu_flag::z>() const { return _flag_z; }
-template <> inline bool register_file::get<cpu_flag::n>() const { return _flag_n; }
-template <> inline bool register_file::get<cpu_flag::h>() const { return _flag_h; }
-template <> inline bool register_file::get<cpu_flag::c>() const { return _flag_c; }
-
-template <> inline void register_file::set<cpu_flag::z>(bool value) { _flag_z = value; }
-template <> inline void register_file::set<cpu_flag::n>(bool value) { _flag_n = value; }
-template <> inline void register_file::set<cpu_flag::h>(bool value) { _flag_h = value; }
-template <> inline void register_file::set<cpu_flag::c>(bool value) { _flag_c = value; }
+template <cpu_flag F> inline bool register_file::get() const { return (_f & static_cast<uint8_t>(F)) != 0; }
+template <cpu_flag F> inline void register_file::set(bool value) { _f = value ? (_f | static_cast<uint8_t>(F)) : (_f & ~static_cast<uint8_t>(F)); }
 
 class z80_cpu : private memory_mapping
 {
@@ -141,8 +135,24 @@ public:
 
 	/** Sets or resets the Interrupt Master Enable flag. */
 	void set_ime(bool value) { _ime = value; }
+	bool ime() const { return _ime; }
 	void post_interrupt(interrupt interrupt);
 	void halt() { _halted = true; _opcode = nullptr; }
+	bool halted() const { return _halted; }
+	/** True if an interrupt would be serviced by the next fetch_decode_execute. */
+	bool interrupt_pending() const;
+
+	/** Idle loop detection. */
+	struct idle_loop
+	{
+		uint16_t polled_addr;  // register read once per iteration, 0 if none
+		cputime iteration_time;
+	};
+	/**
+	 * Returns true if the last instruction jumped back to the start of a side effect free
+	 * loop which only polls a single I/O register (e.g. LY). Resets the jump information.
+	 */
+	bool take_idle_loop(idle_loop &loop);
 
 	/** Fast Mode. */
 	bool double_speed() const { return _double_speed; }
@@ -151,6 +161,10 @@ public:
 	/** DMA. */
 	void set_dma_mode(bool dma) { _memory.set_dma_mode(dma); }
 
+	/** Registers and modes, between two instructions. */
+	void save_state(state_writer &state) const override;
+	void load_state(state_reader &state) override;
+
 private:
 	register_file _registers;
 	gb::memory_map _memory;
@@ -166,6 +180,14 @@ private:
 	bool _double_speed;
 	bool _speed_switch;
 
+	bool _jumped_back;
+	uint16_t _jump_pc;
+	std::array<uint32_t, 0x40> _not_idle_loops;  // (start << 16 | jump pc), indexed by start
+	uint32_t _idle_candidate;
+	uint8_t _idle_candidate_value;
+
+	bool decode_idle_loop(uint16_t start, uint16_t jump_pc, idle_loop &loop) const;
+
 	/** Memory mapping */
 	// TODO pull interrupt registers here
 	bool read8(uint16_t addr, uint8_t &value) const override;
@@ -3,7 +3,7 @@
 #include "z80.hpp"
 #include "debug.hpp"
 #include "assert.hpp"
-#include <string>
+#include <array>
 
 using r8 = gb::register8;
 using r16 = gb::register16;
@@ -25,134 +25,211 @@ enum class operation
 	add, adc, sub, sbc, and_, or_, xor_, cp
 };
 
-std::string to_string(operation op)
-{
-	switch (op)
-	{
-	case operation::add:
-		return "ADD";
-	case operation::adc:
-		return "ADC";
-	case operation::sub:
-		return "SUB";
-	case operation::sbc:
-		return "SBC";
-	case operation::and_:
-		return "AND";
-	case operation::or_:
-		return "OR";
-	case operation::xor_:
-		return "XOR";
-	case operation::cp:
-		return "CP";
-	default:
-		ASSERT_UNREACHABLE();
-	}
-}
+// Flag lookup tables. All tables store the complete F register (lower nibble 0) so
+// the opcodes can set all flags with one store instead of four separate updates.
+const uint8_t flag_z = static_cast<uint8_t>(flag::z);
+const uint8_t flag_n = static_cast<uint8_t>(flag::n);
+const uint8_t flag_h = static_cast<uint8_t>(flag::h);
+const uint8_t flag_c = static_cast<uint8_t>(flag::c);
+
+// Index: carry << 16 | dst << 8 | src
+using alu_table = std::array<uint8_t, 2 * 0x10000>;
 
-uint8_t execute_alu(operation op, uint8_t dst, uint8_t src, gb::register_file &rs)
+alu_table make_add_table()
 {
-	switch (op)
-	{
-	case operation::add:
-	{
-		uint8_t result = dst + src;
-		rs.set<flag::z>(result == 0);
-		rs.set<flag::n>(false);
-		rs.set<flag::h>((dst & 0xF) > 0xF - (src & 0xF));
-		rs.set<flag::c>(dst > 0xFF - src);
-		return result;
-	}
-	case operation::adc:
-	{
-		const bool carry = rs.get<flag::c>();
-		uint8_t result = execute_alu(operation::add, dst, src + (carry ? 1 : 0), rs);
-		if (carry && (src & 0xF) == 0xF)
-			rs.set<flag::h>(true);
-		if (carry && src == 0xFF)
-			rs.set<flag::c>(true);
-		return result;
-	}
-	case operation::sub:
+	alu_table table;
+	for (unsigned int carry = 0; carry <= 1; ++carry)
 	{
-		uint8_t result = dst - src;
-		rs.set<flag::z>(result == 0);
-		rs.set<flag::n>(true);
-		rs.set<flag::h>((dst & 0xF) < (src & 0xF));
-		rs.set<flag::c>(dst < src);
-		return result;
-	}
-	case operation::sbc:
-	{
-		const bool carry = rs.get<flag::c>();
-		uint8_t result = execute_alu(operation::sub, dst, src + (carry ? 1 : 0), rs);
-		if (carry && (src & 0xF) == 0xF)
-			rs.set<flag::h>(true);
-		if (carry && src == 0xFF)
-			rs.set<flag::c>(true);
-		return result;
-	}
-	case operation::and_:
-	{
-		uint8_t result = dst & src;
-		rs.set<flag::z>(result == 0);
-		rs.set<flag::n>(false);
-		rs.set<flag::h>(true);
-		rs.set<flag::c>(false);
-		return result;
+		for (unsigned int dst = 0; dst <= 0xFF; ++dst)
+		{
+			for (unsigned int src = 0; src <= 0xFF; ++src)
+			{
+				const unsigned int result = dst + src + carry;
+				uint8_t f = 0;
+				if ((result & 0xFF) == 0)
+					f |= flag_z;
+				if ((dst & 0xF) + (src & 0xF) + carry > 0xF)
+					f |= flag_h;
+				if (result > 0xFF)
+					f |= flag_c;
+				table[carry << 16 | dst << 8 | src] = f;
+			}
+		}
 	}
-	case operation::or_:
+	return table;
+}
+
+alu_table make_sub_table()
+{
+	alu_table table;
+	for (unsigned int carry = 0; carry <= 1; ++carry)
 	{
-		uint8_t result = dst | src;
-		rs.set<flag::z>(result == 0);
-		rs.set<flag::n>(false);
-		rs.set<flag::h>(false);
-		rs.set<flag::c>(false);
-		return result;
+		for (unsigned int dst = 0; dst <= 0xFF; ++dst)
+		{
+			for (unsigned int src = 0; src <= 0xFF; ++src)
+			{
+				const int result = static_cast<int>(dst) - static_cast<int>(src) - static_cast<int>(carry);
+				uint8_t f = flag_n;
+				if ((result & 0xFF) == 0)
+					f |= flag_z;
+				if (static_cast<int>(dst & 0xF) - static_cast<int>(src & 0xF) - static_cast<int>(carry) < 0)
+					f |= flag_h;
+				if (result < 0)
+					f |= flag_c;
+				table[carry << 16 | dst << 8 | src] = f;
+			}
+		}
 	}
-	case operation::xor_:
+	return table;
+}
+
+// Index: value before INC/DEC, the C flag is not part of the table (it is not affected)
+template <bool Dec>
+std::array<uint8_t, 0x100> make_decinc_table()
+{
+	std::array<uint8_t, 0x100> table;
+	for (unsigned int value = 0; value <= 0xFF; ++value)
 	{
-		uint8_t result = dst ^ src;
-		rs.set<flag::z>(result == 0);
-		rs.set<flag::n>(false);
-		rs.set<flag::h>(false);
-		rs.set<flag::c>(false);
-		return result;
+		const uint8_t result = static_cast<uint8_t>(Dec ? value - 1 : value + 1);
+		uint8_t f = Dec ? flag_n : 0;
+		if (result == 0)
+			f |= flag_z;
+		if ((value & 0x0F) == (Dec ? 0x00 : 0x0F))
+			f |= flag_h;
+		table[value] = f;
 	}
-	case operation::cp:
+	return table;
+}
+
+// Index: F << 4 | A (only the upper nibble of F matters), value: A << 8 | F
+std::array<uint16_t, 0x1000> make_daa_table()
+{
+	// I don't even ...
+	// http://forums.nesdev.com/viewtopic.php?t=9088
+	// https://courses.engr.illinois.edu/ece390/books/artofasm/CH06/CH06-2.html
+	// http://en.wikipedia.org/wiki/Binary-coded_decimal
+	// http://www.emutalk.net/threads/41525-Game-Boy/page109
+
+	std::array<uint16_t, 0x1000> table;
+	for (unsigned int f = 0; f <= 0xF0; f += 0x10)
 	{
-		execute_alu(operation::sub, dst, src, rs);
-		return dst;  // throw away subtraction result
-	}
-	default:
-		ASSERT_UNREACHABLE();
+		for (unsigned int a = 0; a <= 0xFF; ++a)
+		{
+			const bool n = (f & flag_n) != 0;
+			const bool h = (f & flag_h) != 0;
+			bool c = (f & flag_c) != 0;
+			unsigned int value = a;
+
+			if (n)
+			{
+				if (h)
+					value = (value - 6) & 0xFF;
+				if (c)
+					value -= 0x60;
+			}
+			else
+			{
+				if ((value & 0x0F) > 0x09 || h)
+					value += 0x06;
+				if (value > 0x9F || c)
+					value += 0x60;
+			}
+
+			if ((value & 0x100) == 0x100)
+				c = true;  // do not reset c, if already set!
+			value &= 0xFF;
+
+			uint8_t result_f = 0;
+			if (value == 0)
+				result_f |= flag_z;
+			if (n)
+				result_f |= flag_n;
+			if (c)
+				result_f |= flag_c;
+			table[f << 4 | a] = static_cast<uint16_t>(value << 8 | result_f);
+		}
 	}
+	return table;
 }
 
-enum class cond
+const alu_table add_flags = make_add_table();
+const alu_table sub_flags = make_sub_table();
+const std::array<uint8_t, 0x100> inc_flags = make_decinc_table<false>();
+const std::array<uint8_t, 0x100> dec_flags = make_decinc_table<true>();
+const std::array<uint16_t, 0x1000> daa_results = make_daa_table();
+
+unsigned int alu_index(bool carry, uint8_t dst, uint8_t src)
 {
-	nop, nz, z, nc, c
-};
+	return (carry ? 0x10000 : 0) | dst << 8 | src;
+}
+
+template <operation Op> uint8_t execute_alu(uint8_t dst, uint8_t src, gb::register_file &rs);
 
-std::string to_string(cond c)
+template <> uint8_t execute_alu<operation::add>(uint8_t dst, uint8_t src, gb::register_file &rs)
 {
-	switch (c)
-	{
-	case cond::nop:
-		return "";
-	case cond::nz:
-		return "NZ";
-	case cond::z:
-		return "Z";
-	case cond::nc:
-		return "NC";
-	case cond::c:
-		return "C";
-	default:
-		ASSERT_UNREACHABLE();
-	}
+	rs.write8<r8::f>(add_flags[alu_index(false, dst, src)]);
+	return dst + src;
+}
+
+template <> uint8_t execute_alu<operation::adc>(uint8_t dst, uint8_t src, gb::register_file &rs)
+{
+	const bool carry = rs.get<flag::c>();
+	rs.write8<r8::f>(add_flags[alu_index(carry, dst, src)]);
+	return dst + src + (carry ? 1 : 0);
+}
+
+template <> uint8_t execute_alu<operation::sub>(uint8_t dst, uint8_t src, gb::register_file &rs)
+{
+	rs.write8<r8::f>(sub_flags[alu_index(false, dst, src)]);
+	return dst - src;
+}
+
+template <> uint8_t execute_alu<operation::sbc>(uint8_t dst, uint8_t src, gb::register_file &rs)
+{
+	const bool carry = rs.get<flag::c>();
+	rs.write8<r8::f>(sub_flags[alu_index(carry, dst, src)]);
+	return dst - src - (carry ? 1 : 0);
+}
+
+template <> uint8_t execute_alu<operation::and_>(uint8_t dst, uint8_t src, gb::register_file &rs)
+{
+	const uint8_t result = dst & src;
+	rs.write8<r8::f>(flag_h | (result == 0 ? flag_z : 0));
+	return result;
+}
+
+template <> uint8_t execute_alu<operation::or_>(uint8_t dst, uint8_t src, gb::register_file &rs)
+{
+	const uint8_t result = dst | src;
+	rs.write8<r8::f>(result == 0 ? flag_z : 0);
+	return result;
+}
+
+template <> uint8_t execute_alu<operation::xor_>(uint8_t dst, uint8_t src, gb::register_file &rs)
+{
+	const uint8_t result = dst ^ src;
+	rs.write8<r8::f>(result == 0 ? flag_z : 0);
+	return result;
 }
 
+template <> uint8_t execute_alu<operation::cp>(uint8_t dst, uint8_t src, gb::register_file &rs)
+{
+	rs.write8<r8::f>(sub_flags[alu_index(false, dst, src)]);
+	return dst;  // throw away subtraction result
+}
+
+template <bool Dec> uint8_t decinc_impl(gb::register_file &rs, uint8_t value)
+{
+	const uint8_t c = rs.read8<r8::f>() & flag_c;
+	rs.write8<r8::f>(c | (Dec ? dec_flags : inc_flags)[value]);
+	return Dec ? value - 1 : value + 1;
+}
+
+enum class cond
+{
+	nop, nz, z, nc, c
+};
+
 bool check_condition(const gb::z80_cpu &cpu, cond c)
 {
 	auto &rs = cpu.registers();
@@ -182,9 +259,9 @@ template <gb::register8 Dst>
 class opcode_ld_ri : public gb::opcode
 {
 public:
-	opcode_ld_ri() : gb::opcode("LD " + to_string(Dst) + ",$", 1, 8, &execute) {}
+	constexpr opcode_ld_ri() : gb::opcode(1, 8, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().write8<Dst>(cpu.value8());
 	}
@@ -194,9 +271,9 @@ template <gb::register16 Dst>
 class opcode_ld_mi : public gb::opcode
 {
 public:
-	opcode_ld_mi() : gb::opcode("LD (" + to_string(Dst) + "),$", 1, 11, nullptr, 0, nullptr, &execute) {}
+	constexpr opcode_ld_mi() : gb::opcode(1, 11, &execute, step::write) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.memory().write8(cpu.registers().read16<Dst>(), cpu.value8());
 	}
@@ -206,9 +283,9 @@ template <gb::register8 Dst, gb::register8 Src>
 class opcode_ld_rr : public gb::opcode
 {
 public:
-	opcode_ld_rr() : gb::opcode("LD " + to_string(Dst) + "," + to_string(Src), 0, 4, &execute) {}
+	constexpr opcode_ld_rr() : gb::opcode(0, 4, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().write8<Dst>(cpu.registers().read8<Src>());
 	}
@@ -218,9 +295,9 @@ template <gb::register8 Dst, gb::register16 Src>
 class opcode_ld_rm : public gb::opcode
 {
 public:
-	opcode_ld_rm() : gb::opcode("LD " + to_string(Dst) + ",(" + to_string(Src) + ")", 0, 7, nullptr, 0, &execute) {}
+	constexpr opcode_ld_rm() : gb::opcode(0, 7, &execute, step::read) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().write8<Dst>(cpu.memory().read8(cpu.registers().read16<Src>()));
 	}
@@ -230,9 +307,9 @@ template <gb::register8 Dst>
 class opcode_ld_rmi : public gb::opcode
 {
 public:
-	opcode_ld_rmi() : gb::opcode("LD " + to_string(Dst) + ",($)", 2, 15, nullptr, 0, &execute) {}
+	constexpr opcode_ld_rmi() : gb::opcode(2, 15, &execute, step::read) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().write8<Dst>(cpu.memory().read8(cpu.value16()));
 	}
@@ -242,9 +319,9 @@ template <gb::register8 Src>
 class opcode_ld_mir : public gb::opcode
 {
 public:
-	opcode_ld_mir() : gb::opcode("LD ($)," + to_string(Src), 2, 15, nullptr, 0, nullptr, &execute) {}
+	constexpr opcode_ld_mir() : gb::opcode(2, 15, &execute, step::write) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.memory().write8(cpu.value16(), cpu.registers().read8<Src>());
 	}
@@ -254,9 +331,9 @@ template <gb::register16 Dst, gb::register8 Src>
 class opcode_ld_mr : public gb::opcode
 {
 public:
-	opcode_ld_mr() : gb::opcode("LD (" + to_string(Dst) + ")," + to_string(Src), 0, 7, nullptr, 0, nullptr, &execute) {}
+	constexpr opcode_ld_mr() : gb::opcode(0, 7, &execute, step::write) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.memory().write8(cpu.registers().read16<Dst>(), cpu.registers().read8<Src>());
 	}
@@ -266,9 +343,9 @@ public:
 class opcode_ldff_ac : public gb::opcode
 {
 public:
-	opcode_ldff_ac() : gb::opcode("LD A,(ff00h+C)", 0, 7, nullptr, 0, &execute) {}
+	constexpr opcode_ldff_ac() : gb::opcode(0, 7, &execute, step::read) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().write8<r8::a>(cpu.memory().read8(0xFF00 + cpu.registers().read8<r8::c>()));
 	}
@@ -277,9 +354,9 @@ public:
 class opcode_ldff_ai : public gb::opcode
 {
 public:
-	opcode_ldff_ai() : gb::opcode("LD A,(ff00h+$)", 1, 11, nullptr, 0, &execute) {}
+	constexpr opcode_ldff_ai() : gb::opcode(1, 11, &execute, step::read) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().write8<r8::a>(cpu.memory().read8(0xFF00 + cpu.value8()));
 	}
@@ -288,9 +365,9 @@ public:
 class opcode_ldff_ca : public gb::opcode
 {
 public:
-	opcode_ldff_ca() : gb::opcode("LD (ff00h+C),A", 0, 7, nullptr, 0, nullptr, &execute) {}
+	constexpr opcode_ldff_ca() : gb::opcode(0, 7, &execute, step::write) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.memory().write8(0xFF00 + cpu.registers().read8<r8::c>(), cpu.registers().read8<r8::a>());
 	}
@@ -299,9 +376,9 @@ public:
 class opcode_ldff_ia : public gb::opcode
 {
 public:
-	opcode_ldff_ia() : gb::opcode("LD (ff00h+$),A", 1, 11, nullptr, 0, nullptr, &execute) {}
+	constexpr opcode_ldff_ia() : gb::opcode(1, 11, &execute, step::write) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.memory().write8(0xFF00 + cpu.value8(), cpu.registers().read8<r8::a>());
 	}
@@ -311,11 +388,11 @@ template <bool Dec, bool AHL>
 class opcode_lddi : public gb::opcode
 {
 public:
-	opcode_lddi() :
-		gb::opcode(std::string(Dec ? "LDD" : "LDI") + " " + (AHL ? "A,(HL)" : "(HL),A"), 0, 7, nullptr, 0, AHL ? &execute : nullptr, AHL ? nullptr : &execute)
+	constexpr opcode_lddi() :
+		gb::opcode(0, 7, &execute, AHL ? step::read : step::write)
 	{}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		uint16_t hl = cpu.registers().read16<r16::hl>();
 		
@@ -337,9 +414,9 @@ template <gb::register16 Dst>
 class opcode_ld16_ri : public gb::opcode
 {
 public:
-	opcode_ld16_ri() : gb::opcode("LD " + to_string(Dst) + ",$", 2, 12, &execute) {}
+	constexpr opcode_ld16_ri() : gb::opcode(2, 12, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().write16<Dst>(cpu.value16());
 	}
@@ -349,9 +426,9 @@ template <gb::register16 Dst, gb::register16 Src>
 class opcode_ld16_rr : public gb::opcode
 {
 public:
-	opcode_ld16_rr() : gb::opcode("LD " + to_string(Dst) + "," + to_string(Src), 0, 8, &execute) {}
+	constexpr opcode_ld16_rr() : gb::opcode(0, 8, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().write16<Dst>(cpu.registers().read16<Src>());
 	}
@@ -360,9 +437,9 @@ public:
 class opcode_ld16_hlspn : public gb::opcode
 {
 public:
-	opcode_ld16_hlspn() : gb::opcode("LD HL,SP+$", 1, 12, &execute) {}
+	constexpr opcode_ld16_hlspn() : gb::opcode(1, 12, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		const uint16_t sp = cpu.registers().read16<r16::sp>();
 		const uint16_t offset = sign_extend(cpu.value8());
@@ -380,9 +457,9 @@ template <gb::register16 Src>
 class opcode_ld16_mir : public gb::opcode
 {
 public:
-	opcode_ld16_mir() : gb::opcode("LD ($)," + to_string(Src), 2, 20, &execute) {}
+	constexpr opcode_ld16_mir() : gb::opcode(2, 20, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.memory().write16(cpu.value16(), cpu.registers().read16<Src>());
 	}
@@ -393,9 +470,9 @@ template <gb::register16 Src>
 class opcode_push : public gb::opcode
 {
 public:
-	opcode_push() : gb::opcode("PUSH " + to_string(Src), 0, 16, &execute) {}
+	constexpr opcode_push() : gb::opcode(0, 16, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		uint16_t sp = cpu.registers().read16<r16::sp>();
 		sp -= 2;
@@ -408,9 +485,9 @@ template <gb::register16 Dst>
 class opcode_pop : public gb::opcode
 {
 public:
-	opcode_pop() : gb::opcode("POP " + to_string(Dst), 0, 12, &execute) {}
+	constexpr opcode_pop() : gb::opcode(0, 12, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		uint16_t sp = cpu.registers().read16<r16::sp>();
 		cpu.registers().write16<Dst>(cpu.memory().read16(sp));
@@ -423,12 +500,11 @@ template <operation Op, gb::register8 Dst, gb::register8 Src>
 class opcode_alu_rr : public gb::opcode
 {
 public:
-	opcode_alu_rr() : gb::opcode(to_string(Op) + " " + to_string(Dst) + "," + to_string(Src), 0, 4, &execute) {}
+	constexpr opcode_alu_rr() : gb::opcode(0, 4, &execute) {}
 		
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
-		cpu.registers().write8<Dst>(execute_alu(
-			Op,
+		cpu.registers().write8<Dst>(execute_alu<Op>(
 			cpu.registers().read8<Dst>(),
 			cpu.registers().read8<Src>(),
 			cpu.registers()));
@@ -439,12 +515,11 @@ template <operation Op, gb::register8 Dst, gb::register16 Src>
 class opcode_alu_rm : public gb::opcode
 {
 public:
-	opcode_alu_rm() : gb::opcode(to_string(Op) + " " + to_string(Dst) + ",(" + to_string(Src) + ")", 0, 7, nullptr, 0, &execute) {}
+	constexpr opcode_alu_rm() : gb::opcode(0, 7, &execute, step::read) {}
 		
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
-		cpu.registers().write8<Dst>(execute_alu(
-			Op,
+		cpu.registers().write8<Dst>(execute_alu<Op>(
 			cpu.registers().read8<Dst>(),
 			cpu.memory().read8(cpu.registers().read16<Src>()),
 			cpu.registers()));
@@ -455,12 +530,11 @@ template <operation Op, gb::register8 Dst>
 class opcode_alu_ri : public gb::opcode
 {
 public:
-	opcode_alu_ri() : gb::opcode(to_string(Op) + " " + to_string(Dst) + ",$", 1, 8, &execute) {}
+	constexpr opcode_alu_ri() : gb::opcode(1, 8, &execute) {}
 		
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
-		cpu.registers().write8<Dst>(execute_alu(
-			Op,
+		cpu.registers().write8<Dst>(execute_alu<Op>(
 			cpu.registers().read8<Dst>(),
 			cpu.value8(),
 			cpu.registers()));
@@ -472,25 +546,11 @@ template <bool Dec, gb::register8 Dst>
 class opcode_decinc_r : public gb::opcode
 {
 public:
-	opcode_decinc_r() : gb::opcode(std::string(Dec ? "DEC" : "INC") + " " + to_string(Dst), 0, 4, &execute) {}
+	constexpr opcode_decinc_r() : gb::opcode(0, 4, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
-		uint8_t value = cpu.registers().read8<Dst>();
-		if (Dec)
-		{
-			cpu.registers().set<flag::n>(true);
-			cpu.registers().set<flag::h>((value & 0x0F) == 0x00);
-			--value;
-		}
-		else  // Inc
-		{
-			cpu.registers().set<flag::n>(false);
-			cpu.registers().set<flag::h>((value & 0x0F) == 0x0F);
-			++value;
-		}
-		cpu.registers().set<flag::z>(value == 0);
-		cpu.registers().write8<Dst>(value);
+		cpu.registers().write8<Dst>(decinc_impl<Dec>(cpu.registers(), cpu.registers().read8<Dst>()));
 	}
 };
 
@@ -498,7 +558,15 @@ template <bool Dec, gb::register16 Dst>
 class opcode_decinc_rm : public gb::opcode
 {
 public:
-	opcode_decinc_rm() : gb::opcode(std::string(Dec ? "DEC" : "INC") + " (" + to_string(Dst) + ")", 0, 10, nullptr, 0, &execute_read, &execute_write) {}
+	constexpr opcode_decinc_rm() : gb::opcode(0, 10, &execute, step::read | step::write) {}
+
+	static void execute(gb::z80_cpu &cpu, step current)
+	{
+		if (current == step::read)
+			execute_read(cpu);
+		else
+			execute_write(cpu);
+	}
 
 	static void execute_read(gb::z80_cpu &cpu)
 	{
@@ -507,21 +575,7 @@ public:
 
 	static void execute_write(gb::z80_cpu &cpu)
 	{
-		uint8_t value = cpu.temp();
-		if (Dec)
-		{
-			cpu.registers().set<flag::n>(true);
-			cpu.registers().set<flag::h>((value & 0x0F) == 0x00);
-			--value;
-		}
-		else  // Inc
-		{
-			cpu.registers().set<flag::n>(false);
-			cpu.registers().set<flag::h>((value & 0x0F) == 0x0F);
-			++value;
-		}
-		cpu.registers().set<flag::z>(value == 0);
-		cpu.memory().write8(cpu.registers().read16<Dst>(), value);
+		cpu.memory().write8(cpu.registers().read16<Dst>(), decinc_impl<Dec>(cpu.registers(), cpu.temp()));
 	}
 };
 
@@ -529,9 +583,9 @@ template <gb::register16 Src>
 class opcode_add16_hl : public gb::opcode
 {
 public:
-	opcode_add16_hl() : gb::opcode("ADD HL," + to_string(Src), 0, 8, &execute) {}
+	constexpr opcode_add16_hl() : gb::opcode(0, 8, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		uint16_t hl = cpu.registers().read16<r16::hl>();
 		uint16_t offset = cpu.registers().read16<Src>();
@@ -548,9 +602,9 @@ public:
 class opcode_add16_sp_i : public gb::opcode
 {
 public:
-	opcode_add16_sp_i() : gb::opcode("ADD SP,$", 1, 16, &execute) {}
+	constexpr opcode_add16_sp_i() : gb::opcode(1, 16, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		uint16_t sp = cpu.registers().read16<r16::sp>();
 		uint16_t offset = sign_extend(cpu.value8());
@@ -569,9 +623,9 @@ template <bool Dec, gb::register16 Dst>
 class opcode_decinc16_r : public gb::opcode
 {
 public:
-	opcode_decinc16_r() : gb::opcode(std::string(Dec ? "DEC" : "INC") + " " + to_string(Dst), 0, 8, &execute) {}
+	constexpr opcode_decinc16_r() : gb::opcode(0, 8, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		uint16_t value = cpu.registers().read16<Dst>();
 		if (Dec)
@@ -585,56 +639,22 @@ public:
 class opcode_daa : public gb::opcode
 {
 public:
-	opcode_daa() : gb::opcode("DAA", 0, 4, &execute) {}
+	constexpr opcode_daa() : gb::opcode(0, 4, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
-		// I don't even ...
-		// http://forums.nesdev.com/viewtopic.php?t=9088
-		// https://courses.engr.illinois.edu/ece390/books/artofasm/CH06/CH06-2.html
-		// http://en.wikipedia.org/wiki/Binary-coded_decimal
-		// http://www.emutalk.net/threads/41525-Game-Boy/page109
-
-		unsigned int value = cpu.registers().read8<r8::a>();
-
-		if (cpu.registers().get<flag::n>())
-		{
-			if (cpu.registers().get<flag::h>())
-			{
-				value = (value - 6) & 0xFF;
-			}
-			if (cpu.registers().get<flag::c>())
-			{
-				value -= 0x60;
-			}
-		}
-		else
-		{
-			if ((value & 0x0F) > 0x09 || cpu.registers().get<flag::h>())
-			{
-				value += 0x06;
-			}
-			if (value > 0x9F || cpu.registers().get<flag::c>())
-			{
-				value += 0x60;
-			}
-		}
-		
-		cpu.registers().set<flag::h>(false);
-		if ((value & 0x100) == 0x100)
-			cpu.registers().set<flag::c>(true);  // do not reset c, if already set!
-		value &= 0xFF;
-		cpu.registers().set<flag::z>(value == 0);
-		cpu.registers().write8<r8::a>(static_cast<uint8_t>(value));
+		const uint16_t result = daa_results[cpu.registers().read8<r8::f>() << 4 | cpu.registers().read8<r8::a>()];
+		cpu.registers().write8<r8::a>(static_cast<uint8_t>(result >> 8));
+		cpu.registers().write8<r8::f>(static_cast<uint8_t>(result & 0xFF));
 	}
 };
 
 class opcode_cpl : public gb::opcode
 {
 public:
-	opcode_cpl() : gb::opcode("CPL", 0, 4, &execute) {}
+	constexpr opcode_cpl() : gb::opcode(0, 4, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().write8<r8::a>(~cpu.registers().read8<r8::a>());
 		cpu.registers().set<flag::n>(true);
@@ -645,9 +665,9 @@ public:
 class opcode_ccf : public gb::opcode
 {
 public:
-	opcode_ccf() : gb::opcode("CCF", 0, 4, &execute) {}
+	constexpr opcode_ccf() : gb::opcode(0, 4, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().set<flag::n>(false);
 		cpu.registers().set<flag::h>(false);
@@ -658,9 +678,9 @@ public:
 class opcode_scf : public gb::opcode
 {
 public:
-	opcode_scf() : gb::opcode("SCF", 0, 4, &execute) {}
+	constexpr opcode_scf() : gb::opcode(0, 4, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().set<flag::n>(false);
 		cpu.registers().set<flag::h>(false);
@@ -671,9 +691,9 @@ public:
 class opcode_halt : public gb::opcode
 {
 public:
-	opcode_halt() : gb::opcode("HALT", 0, 4, &execute) {}
+	constexpr opcode_halt() : gb::opcode(0, 4, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.halt();
 	}
@@ -682,9 +702,9 @@ public:
 class opcode_stop : public gb::opcode
 {
 public:
-	opcode_stop() : gb::opcode("STOP", 0, 4, &execute) {}
+	constexpr opcode_stop() : gb::opcode(0, 4, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.stop();
 	}
@@ -693,9 +713,9 @@ public:
 class opcode_di : public gb::opcode
 {
 public:
-	opcode_di() : gb::opcode("DI", 0, 4, &execute) {}
+	constexpr opcode_di() : gb::opcode(0, 4, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.set_ime(false);
 	}
@@ -704,9 +724,9 @@ public:
 class opcode_ei : public gb::opcode
 {
 public:
-	opcode_ei() : gb::opcode("EI", 0, 4, &execute) {}
+	constexpr opcode_ei() : gb::opcode(0, 4, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.set_ime(true);
 	}
@@ -715,7 +735,9 @@ public:
 class opcode_nop : public gb::opcode
 {
 public:
-	opcode_nop() : gb::opcode("NOP", 0, 4, nullptr) {}
+	constexpr opcode_nop() : gb::opcode(0, 4, &execute) {}
+
+	static void execute(gb::z80_cpu &, step) {}
 };
 
 template <bool Left, bool Carry, bool CorrectZ> uint8_t rd_impl(gb::z80_cpu &cpu, uint8_t value)
@@ -760,9 +782,9 @@ template <bool Left, bool Carry>
 class opcode_rda : public gb::opcode
 {
 public:
-	opcode_rda() : gb::opcode(std::string("R") + (Left ? "L" : "R") + (Carry ? "C" : "") + "A", 0, 4, &execute) {}
+	constexpr opcode_rda() : gb::opcode(0, 4, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().write8<r8::a>(rd_impl<Left, Carry, false>(cpu, cpu.registers().read8<r8::a>()));
 	}
@@ -772,9 +794,9 @@ template <cond Cond>
 class opcode_jp_i : public gb::opcode
 {
 public:
-	opcode_jp_i() : gb::opcode("JP " + to_string(Cond) + (Cond == cond::nop ? "" : ",") + "$", 2, 12, &execute, 4) {}
+	constexpr opcode_jp_i() : gb::opcode(2, 12, &execute, step::base, 4) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		if (check_condition(cpu, Cond))
 		{
@@ -787,9 +809,9 @@ public:
 class opcode_jp_hl : public gb::opcode
 {
 public:
-	opcode_jp_hl() : gb::opcode("JP HL", 0, 4, &execute) {}
+	constexpr opcode_jp_hl() : gb::opcode(0, 4, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().write16<r16::pc>(cpu.registers().read16<r16::hl>());
 	}
@@ -799,9 +821,9 @@ template <cond Cond>
 class opcode_jr_i : public gb::opcode
 {
 public:
-	opcode_jr_i() : gb::opcode("JR " + to_string(Cond) + (Cond == cond::nop ? "" : ",") + "$", 1, 8, &execute, 4) {}
+	constexpr opcode_jr_i() : gb::opcode(1, 8, &execute, step::base, 4) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		if (check_condition(cpu, Cond))
 		{
@@ -816,9 +838,9 @@ template <cond Cond>
 class opcode_call : public gb::opcode
 {
 public:
-	opcode_call() : gb::opcode("CALL " + to_string(Cond) + (Cond == cond::nop ? "" : ",") + "$", 2, 12, &execute, 12) {}
+	constexpr opcode_call() : gb::opcode(2, 12, &execute, step::base, 12) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		if (check_condition(cpu, Cond))
 		{
@@ -837,9 +859,9 @@ template <uint8_t Addr>
 class opcode_rst : public gb::opcode
 {
 public:
-	opcode_rst() : gb::opcode("RST " + std::to_string(Addr), 0, 16, &execute) {}
+	constexpr opcode_rst() : gb::opcode(0, 16, &execute) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		uint16_t pc = cpu.registers().read16<r16::pc>();
 		uint16_t sp = cpu.registers().read16<r16::sp>();
@@ -854,9 +876,9 @@ template <cond Cond, bool Ei>
 class opcode_ret : public gb::opcode
 {
 public:
-	opcode_ret() : gb::opcode(std::string("RET") + (Ei ? "I" : "") + (Cond == cond::nop ? std::string("") : (" " + to_string(Cond))), 0, Cond == cond::nop ? 4 : 8, &execute, 12) {}
+	constexpr opcode_ret() : gb::opcode(0, Cond == cond::nop ? 4 : 8, &execute, step::base, 12) {}
 
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		if (check_condition(cpu, Cond))
 		{
@@ -876,9 +898,9 @@ public:
 class opcode_hang : public gb::opcode
 {
 public:
-	opcode_hang() : gb::opcode("HANG", 0, 4, &execute) {}
+	constexpr opcode_hang() : gb::opcode(0, 4, &execute) {}
 	
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		debug("WARNING: Game used invalid opcode, hang");
 		cpu.set_ime(false);
@@ -890,11 +912,11 @@ template <bool Left, bool Carry, gb::register8 Dst>
 class opcode_cb_rdc_r : public gb::opcode
 {
 public:
-	opcode_cb_rdc_r() :
-		gb::opcode(std::string("R") + (Left ? "L" : "R") + (Carry ? "C" : "") + " " + to_string(Dst), 0, 8, &execute)
+	constexpr opcode_cb_rdc_r() :
+		gb::opcode(0, 8, &execute)
 	{}
 	
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().write8<Dst>(rd_impl<Left, Carry, true>(cpu, cpu.registers().read8<Dst>()));
 	}
@@ -904,10 +926,18 @@ template <bool Left, bool Carry, gb::register16 Dst>
 class opcode_cb_rdc_m : public gb::opcode
 {
 public:
-	opcode_cb_rdc_m() :
-		gb::opcode(std::string("R") + (Left ? "L" : "R") + (Carry ? "C" : "") + " (" + to_string(Dst) + ")", 0, 14, nullptr, 0, &execute_read, &execute_write)
+	constexpr opcode_cb_rdc_m() :
+		gb::opcode(0, 14, &execute, step::read | step::write)
 	{}
 	
+	static void execute(gb::z80_cpu &cpu, step current)
+	{
+		if (current == step::read)
+			execute_read(cpu);
+		else
+			execute_write(cpu);
+	}
+
 	static void execute_read(gb::z80_cpu &cpu)
 	{
 		uint16_t addr = cpu.registers().read16<Dst>();
@@ -949,11 +979,11 @@ template <bool Left, gb::register8 Dst>
 class opcode_cb_sda_r : public gb::opcode
 {
 public:
-	opcode_cb_sda_r() :
-		gb::opcode(std::string("S") + (Left ? "L" : "R") + "A " + to_string(Dst), 0, 8, &execute)
+	constexpr opcode_cb_sda_r() :
+		gb::opcode(0, 8, &execute)
 	{}
 	
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().write8<Dst>(sda_impl<Left>(cpu, cpu.registers().read8<Dst>()));
 	}
@@ -963,10 +993,18 @@ template <bool Left, gb::register16 Dst>
 class opcode_cb_sda_m : public gb::opcode
 {
 public:
-	opcode_cb_sda_m() :
-		gb::opcode(std::string("S") + (Left ? "L" : "R") + "A (" + to_string(Dst) + ")", 0, 14, nullptr, 0, &execute_read, &execute_write)
+	constexpr opcode_cb_sda_m() :
+		gb::opcode(0, 14, &execute, step::read | step::write)
 	{}
 
+	static void execute(gb::z80_cpu &cpu, step current)
+	{
+		if (current == step::read)
+			execute_read(cpu);
+		else
+			execute_write(cpu);
+	}
+
 	static void execute_read(gb::z80_cpu &cpu)
 	{
 		uint16_t addr = cpu.registers().read16<Dst>();
@@ -996,11 +1034,11 @@ template <gb::register8 Dst>
 class opcode_cb_swap_r : public gb::opcode
 {
 public:
-	opcode_cb_swap_r() :
-		gb::opcode("SWAP " + to_string(Dst), 0, 8, &execute)
+	constexpr opcode_cb_swap_r() :
+		gb::opcode(0, 8, &execute)
 	{}
 	
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().write8<Dst>(swap_impl(cpu, cpu.registers().read8<Dst>()));
 	}
@@ -1010,10 +1048,18 @@ template <gb::register16 Dst>
 class opcode_cb_swap_m : public gb::opcode
 {
 public:
-	opcode_cb_swap_m() :
-		gb::opcode("SWAP (" + to_string(Dst) + ")", 0, 14, nullptr, 0, &execute_read, &execute_write)
+	constexpr opcode_cb_swap_m() :
+		gb::opcode(0, 14, &execute, step::read | step::write)
 	{}
 	
+	static void execute(gb::z80_cpu &cpu, step current)
+	{
+		if (current == step::read)
+			execute_read(cpu);
+		else
+			execute_write(cpu);
+	}
+
 	static void execute_read(gb::z80_cpu &cpu)
 	{
 		uint16_t addr = cpu.registers().read16<Dst>();
@@ -1042,11 +1088,11 @@ template <gb::register8 Dst>
 class opcode_cb_srl_r : public gb::opcode
 {
 public:
-	opcode_cb_srl_r() :
-		gb::opcode("SRL " + to_string(Dst), 0, 8, &execute)
+	constexpr opcode_cb_srl_r() :
+		gb::opcode(0, 8, &execute)
 	{}
 	
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().write8<Dst>(srl_impl(cpu, cpu.registers().read8<Dst>()));
 	}
@@ -1056,10 +1102,18 @@ template <gb::register16 Dst>
 class opcode_cb_srl_m : public gb::opcode
 {
 public:
-	opcode_cb_srl_m() :
-		gb::opcode("SRL (" + to_string(Dst) + ")", 0, 14, nullptr, 0, &execute_read, &execute_write)
+	constexpr opcode_cb_srl_m() :
+		gb::opcode(0, 14, &execute, step::read | step::write)
 	{}
 	
+	static void execute(gb::z80_cpu &cpu, step current)
+	{
+		if (current == step::read)
+			execute_read(cpu);
+		else
+			execute_write(cpu);
+	}
+
 	static void execute_read(gb::z80_cpu &cpu)
 	{
 		uint16_t addr = cpu.registers().read16<Dst>();
@@ -1077,11 +1131,11 @@ template <uint8_t bit, gb::register8 Dst>
 class opcode_cb_bit_r : public gb::opcode
 {
 public:
-	opcode_cb_bit_r() :
-		gb::opcode("BIT " + std::to_string(bit) + "," + to_string(Dst), 0, 8, &execute)
+	constexpr opcode_cb_bit_r() :
+		gb::opcode(0, 8, &execute)
 	{}
 	
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		cpu.registers().set<flag::z>((cpu.registers().read8<Dst>() & (1 << bit)) == 0);
 		cpu.registers().set<flag::n>(false);
@@ -1093,11 +1147,11 @@ template <uint8_t bit, gb::register16 Dst>
 class opcode_cb_bit_m : public gb::opcode
 {
 public:
-	opcode_cb_bit_m() :
-		gb::opcode("BIT " + std::to_string(bit) + ",(" + to_string(Dst) + ")", 0, 11, nullptr, 0, &execute)
+	constexpr opcode_cb_bit_m() :
+		gb::opcode(0, 11, &execute, step::read)
 	{}
 	
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		uint16_t addr = cpu.registers().read16<Dst>();
 		cpu.registers().set<flag::z>((cpu.memory().read8(addr) & (1 << bit)) == 0);
@@ -1110,11 +1164,11 @@ template <bool res, uint8_t bit, gb::register8 Dst>
 class opcode_cb_resset_r : public gb::opcode
 {
 public:
-	opcode_cb_resset_r() :
-		gb::opcode((res ? "RES " : "SET ") + std::to_string(bit) + "," + to_string(Dst), 0, 8, &execute)
+	constexpr opcode_cb_resset_r() :
+		gb::opcode(0, 8, &execute)
 	{}
 	
-	static void execute(gb::z80_cpu &cpu)
+	static void execute(gb::z80_cpu &cpu, step)
 	{
 		uint8_t b = 1 << bit;
 		if (res)
@@ -1128,10 +1182,18 @@ template <bool res, uint8_t bit, gb::register16 Dst>
 class opcode_cb_resset_m : public gb::opcode
 {
 public:
-	opcode_cb_resset_m() :
-		gb::opcode((res ? "RES " : "SET ") + std::to_string(bit) + ",(" + to_string(Dst) + ")", 0, 14, nullptr, 0, &execute_read, &execute_write)
+	constexpr opcode_cb_resset_m() :
+		gb::opcode(0, 14, &execute, step::read | step::write)
 	{}
 
+	static void execute(gb::z80_cpu &cpu, step current)
+	{
+		if (current == step::read)
+			execute_read(cpu);
+		else
+			execute_write(cpu);
+	}
+
 	static void execute_read(gb::z80_cpu &cpu)
 	{
 		uint16_t addr = cpu.registers().read16<Dst>();
@@ -1151,7 +1213,7 @@ public:
 
 }
 
-const gb::opcode_table gb::opcodes{{
+constexpr gb::opcode_table gb::opcodes{{
 	/* ops[0x00] = */ opcode_nop(),
 	/* ops[0x01] = */ opcode_ld16_ri<r16::bc>(),
 	/* ops[0x02] = */ opcode_ld_mr<r16::bc, r8::a>(),
@@ -1410,7 +1472,7 @@ const gb::opcode_table gb::opcodes{{
 	/* ops[0xFF] = */ opcode_rst<0x38>()
 }};
 
-const gb::opcode_table gb::cb_opcodes{{
+constexpr gb::opcode_table gb::cb_opcodes{{
 	/* cb[0x00] = */ opcode_cb_rdc_r<true, true, r8::b>(),
 	/* cb[0x01] = */ opcode_cb_rdc_r<true, true, r8::c>(),
 	/* cb[0x02] = */ opcode_cb_rdc_r<true, true, r8::d>(),
@@ -1668,3 +1730,530 @@ const gb::opcode_table gb::cb_opcodes{{
 	/* cb[0xFE] = */ opcode_cb_resset_m<false, 7, r16::hl>(),
 	/* cb[0xFF] = */ opcode_cb_resset_r<false, 7, r8::a>()
 }};
+
+const gb::mnemonic_table gb::opcode_mnemonics{{
+	/* ops[0x00] = */ "NOP",
+	/* ops[0x01] = */ "LD BC,$",
+	/* ops[0x02] = */ "LD (BC),A",
+	/* ops[0x03] = */ "INC BC",
+	/* ops[0x04] = */ "INC B",
+	/* ops[0x05] = */ "DEC B",
+	/* ops[0x06] = */ "LD B,$",
+	/* ops[0x07] = */ "RLCA",
+	/* ops[0x08] = */ "LD ($),SP",
+	/* ops[0x09] = */ "ADD HL,BC",
+	/* ops[0x0A] = */ "LD A,(BC)",
+	/* ops[0x0B] = */ "DEC BC",
+	/* ops[0x0C] = */ "INC C",
+	/* ops[0x0D] = */ "DEC C",
+	/* ops[0x0E] = */ "LD C,$",
+	/* ops[0x0F] = */ "RRCA",
+	/* ops[0x10] = */ "STOP",
+	/* ops[0x11] = */ "LD DE,$",
+	/* ops[0x12] = */ "LD (DE),A",
+	/* ops[0x13] = */ "INC DE",
+	/* ops[0x14] = */ "INC D",
+	/* ops[0x15] = */ "DEC D",
+	/* ops[0x16] = */ "LD D,$",
+	/* ops[0x17] = */ "RLA",
+	/* ops[0x18] = */ "JR $",
+	/* ops[0x19] = */ "ADD HL,DE",
+	/* ops[0x1A] = */ "LD A,(DE)",
+	/* ops[0x1B] = */ "DEC DE",
+	/* ops[0x1C] = */ "INC E",
+	/* ops[0x1D] = */ "DEC E",
+	/* ops[0x1E] = */ "LD E,$",
+	/* ops[0x1F] = */ "RRA",
+	/* ops[0x20] = */ "JR NZ,$",
+	/* ops[0x21] = */ "LD HL,$",
+	/* ops[0x22] = */ "LDI (HL),A",
+	/* ops[0x23] = */ "INC HL",
+	/* ops[0x24] = */ "INC H",
+	/* ops[0x25] = */ "DEC H",
+	/* ops[0x26] = */ "LD H,$",
+	/* ops[0x27] = */ "DAA",
+	/* ops[0x28] = */ "JR Z,$",
+	/* ops[0x29] = */ "ADD HL,HL",
+	/* ops[0x2A] = */ "LDI A,(HL)",
+	/* ops[0x2B] = */ "DEC HL",
+	/* ops[0x2C] = */ "INC L",
+	/* ops[0x2D] = */ "DEC L",
+	/* ops[0x2E] = */ "LD L,$",
+	/* ops[0x2F] = */ "CPL",
+	/* ops[0x30] = */ "JR NC,$",
+	/* ops[0x31] = */ "LD SP,$",
+	/* ops[0x32] = */ "LDD (HL),A",
+	/* ops[0x33] = */ "INC SP",
+	/* ops[0x34] = */ "INC (HL)",
+	/* ops[0x35] = */ "DEC (HL)",
+	/* ops[0x36] = */ "LD (HL),$",
+	/* ops[0x37] = */ "SCF",
+	/* ops[0x38] = */ "JR C,$",
+	/* ops[0x39] = */ "ADD HL,SP",
+	/* ops[0x3A] = */ "LDD A,(HL)",
+	/* ops[0x3B] = */ "DEC SP",
+	/* ops[0x3C] = */ "INC A",
+	/* ops[0x3D] = */ "DEC A",
+	/* ops[0x3E] = */ "LD A,$",
+	/* ops[0x3F] = */ "CCF",
+	/* ops[0x40] = */ "LD B,B",
+	/* ops[0x41] = */ "LD B,C",
+	/* ops[0x42] = */ "LD B,D",
+	/* ops[0x43] = */ "LD B,E",
+	/* ops[0x44] = */ "LD B,H",
+	/* ops[0x45] = */ "LD B,L",
+	/* ops[0x46] = */ "LD B,(HL)",
+	/* ops[0x47] = */ "LD B,A",
+	/* ops[0x48] = */ "LD C,B",
+	/* ops[0x49] = */ "LD C,C",
+	/* ops[0x4A] = */ "LD C,D",
+	/* ops[0x4B] = */ "LD C,E",
+	/* ops[0x4C] = */ "LD C,H",
+	/* ops[0x4D] = */ "LD C,L",
+	/* ops[0x4E] = */ "LD C,(HL)",
+	/* ops[0x4F] = */ "LD C,A",
+	/* ops[0x50] = */ "LD D,B",
+	/* ops[0x51] = */ "LD D,C",
+	/* ops[0x52] = */ "LD D,D",
+	/* ops[0x53] = */ "LD D,E",
+	/* ops[0x54] = */ "LD D,H",
+	/* ops[0x55] = */ "LD D,L",
+	/* ops[0x56] = */ "LD D,(HL)",
+	/* ops[0x57] = */ "LD D,A",
+	/* ops[0x58] = */ "LD E,B",
+	/* ops[0x59] = */ "LD E,C",
+	/* ops[0x5A] = */ "LD E,D",
+	/* ops[0x5B] = */ "LD E,E",
+	/* ops[0x5C] = */ "LD E,H",
+	/* ops[0x5D] = */ "LD E,L",
+	/* ops[0x5E] = */ "LD E,(HL)",
+	/* ops[0x5F] = */ "LD E,A",
+	/* ops[0x60] = */ "LD H,B",
+	/* ops[0x61] = */ "LD H,C",
+	/* ops[0x62] = */ "LD H,D",
+	/* ops[0x63] = */ "LD H,E",
+	/* ops[0x64] = */ "LD H,H",
+	/* ops[0x65] = */ "LD H,L",
+	/* ops[0x66] = */ "LD H,(HL)",
+	/* ops[0x67] = */ "LD H,A",
+	/* ops[0x68] = */ "LD L,B",
+	/* ops[0x69] = */ "LD L,C",
+	/* ops[0x6A] = */ "LD L,D",
+	/* ops[0x6B] = */ "LD L,E",
+	/* ops[0x6C] = */ "LD L,H",
+	/* ops[0x6D] = */ "LD L,L",
+	/* ops[0x6E] = */ "LD L,(HL)",
+	/* ops[0x6F] = */ "LD L,A",
+	/* ops[0x70] = */ "LD (HL),B",
+	/* ops[0x71] = */ "LD (HL),C",
+	/* ops[0x72] = */ "LD (HL),D",
+	/* ops[0x73] = */ "LD (HL),E",
+	/* ops[0x74] = */ "LD (HL),H",
+	/* ops[0x75] = */ "LD (HL),L",
+	/* ops[0x76] = */ "HALT",
+	/* ops[0x77] = */ "LD (HL),A",
+	/* ops[0x78] = */ "LD A,B",
+	/* ops[0x79] = */ "LD A,C",
+	/* ops[0x7A] = */ "LD A,D",
+	/* ops[0x7B] = */ "LD A,E",
+	/* ops[0x7C] = */ "LD A,H",
+	/* ops[0x7D] = */ "LD A,L",
+	/* ops[0x7E] = */ "LD A,(HL)",
+	/* ops[0x7F] = */ "LD A,A",
+	/* ops[0x80] = */ "ADD A,B",
+	/* ops[0x81] = */ "ADD A,C",
+	/* ops[0x82] = */ "ADD A,D",
+	/* ops[0x83] = */ "ADD A,E",
+	/* ops[0x84] = */ "ADD A,H",
+	/* ops[0x85] = */ "ADD A,L",
+	/* ops[0x86] = */ "ADD A,(HL)",
+	/* ops[0x87] = */ "ADD A,A",
+	/* ops[0x88] = */ "ADC A,B",
+	/* ops[0x89] = */ "ADC A,C",
+	/* ops[0x8A] = */ "ADC A,D",
+	/* ops[0x8B] = */ "ADC A,E",
+	/* ops[0x8C] = */ "ADC A,H",
+	/* ops[0x8D] = */ "ADC A,L",
+	/* ops[0x8E] = */ "ADC A,(HL)",
+	/* ops[0x8F] = */ "ADC A,A",
+	/* ops[0x90] = */ "SUB A,B",
+	/* ops[0x91] = */ "SUB A,C",
+	/* ops[0x92] = */ "SUB A,D",
+	/* ops[0x93] = */ "SUB A,E",
+	/* ops[0x94] = */ "SUB A,H",
+	/* ops[0x95] = */ "SUB A,L",
+	/* ops[0x96] = */ "SUB A,(HL)",
+	/* ops[0x97] = */ "SUB A,A",
+	/* ops[0x98] = */ "SBC A,B",
+	/* ops[0x99] = */ "SBC A,C",
+	/* ops[0x9A] = */ "SBC A,D",
+	/* ops[0x9B] = */ "SBC A,E",
+	/* ops[0x9C] = */ "SBC A,H",
+	/* ops[0x9D] = */ "SBC A,L",
+	/* ops[0x9E] = */ "SBC A,(HL)",
+	/* ops[0x9F] = */ "SBC A,A",
+	/* ops[0xA0] = */ "AND A,B",
+	/* ops[0xA1] = */ "AND A,C",
+	/* ops[0xA2] = */ "AND A,D",
+	/* ops[0xA3] = */ "AND A,E",
+	/* ops[0xA4] = */ "AND A,H",
+	/* ops[0xA5] = */ "AND A,L",
+	/* ops[0xA6] = */ "AND A,(HL)",
+	/* ops[0xA7] = */ "AND A,A",
+	/* ops[0xA8] = */ "XOR A,B",
+	/* ops[0xA9] = */ "XOR A,C",
+	/* ops[0xAA] = */ "XOR A,D",
+	/* ops[0xAB] = */ "XOR A,E",
+	/* ops[0xAC] = */ "XOR A,H",
+	/* ops[0xAD] = */ "XOR A,L",
+	/* ops[0xAE] = */ "XOR A,(HL)",
+	/* ops[0xAF] = */ "XOR A,A",
+	/* ops[0xB0] = */ "OR A,B",
+	/* ops[0xB1] = */ "OR A,C",
+	/* ops[0xB2] = */ "OR A,D",
+	/* ops[0xB3] = */ "OR A,E",
+	/* ops[0xB4] = */ "OR A,H",
+	/* ops[0xB5] = */ "OR A,L",
+	/* ops[0xB6] = */ "OR A,(HL)",
+	/* ops[0xB7] = */ "OR A,A",
+	/* ops[0xB8] = */ "CP A,B",
+	/* ops[0xB9] = */ "CP A,C",
+	/* ops[0xBA] = */ "CP A,D",
+	/* ops[0xBB] = */ "CP A,E",
+	/* ops[0xBC] = */ "CP A,H",
+	/* ops[0xBD] = */ "CP A,L",
+	/* ops[0xBE] = */ "CP A,(HL)",
+	/* ops[0xBF] = */ "CP A,A",
+	/* ops[0xC0] = */ "RET NZ",
+	/* ops[0xC1] = */ "POP BC",
+	/* ops[0xC2] = */ "JP NZ,$",
+	/* ops[0xC3] = */ "JP $",
+	/* ops[0xC4] = */ "CALL NZ,$",
+	/* ops[0xC5] = */ "PUSH BC",
+	/* ops[0xC6] = */ "ADD A,$",
+	/* ops[0xC7] = */ "RST 0",
+	/* ops[0xC8] = */ "RET Z",
+	/* ops[0xC9] = */ "RET",
+	/* ops[0xCA] = */ "JP Z,$",
+	/* ops[0xCB] = */ "HANG",
+	/* ops[0xCC] = */ "CALL Z,$",
+	/* ops[0xCD] = */ "CALL $",
+	/* ops[0xCE] = */ "ADC A,$",
+	/* ops[0xCF] = */ "RST 8",
+	/* ops[0xD0] = */ "RET NC",
+	/* ops[0xD1] = */ "POP DE",
+	/* ops[0xD2] = */ "JP NC,$",
+	/* ops[0xD3] = */ "HANG",
+	/* ops[0xD4] = */ "CALL NC,$",
+	/* ops[0xD5] = */ "PUSH DE",
+	/* ops[0xD6] = */ "SUB A,$",
+	/* ops[0xD7] = */ "RST 16",
+	/* ops[0xD8] = */ "RET C",
+	/* ops[0xD9] = */ "RETI",
+	/* ops[0xDA] = */ "JP C,$",
+	/* ops[0xDB] = */ "HANG",
+	/* ops[0xDC] = */ "CALL C,$",
+	/* ops[0xDD] = */ "HANG",
+	/* ops[0xDE] = */ "SBC A,$",
+	/* ops[0xDF] = */ "RST 24",
+	/* ops[0xE0] = */ "LD (ff00h+$),A",
+	/* ops[0xE1] = */ "POP HL",
+	/* ops[0xE2] = */ "LD (ff00h+C),A",
+	/* ops[0xE3] = */ "HANG",
+	/* ops[0xE4] = */ "HANG",
+	/* ops[0xE5] = */ "PUSH HL",
+	/* ops[0xE6] = */ "AND A,$",
+	/* ops[0xE7] = */ "RST 32",
+	/* ops[0xE8] = */ "ADD SP,$",
+	/* ops[0xE9] = */ "JP HL",
+	/* ops[0xEA] = */ "LD ($),A",
+	/* ops[0xEB] = */ "HANG",
+	/* ops[0xEC] = */ "HANG",
+	/* ops[0xED] = */ "HANG",
+	/* ops[0xEE] = */ "XOR A,$",
+	/* ops[0xEF] = */ "RST 40",
+	/* ops[0xF0] = */ "LD A,(ff00h+$)",
+	/* ops[0xF1] = */ "POP AF",
+	/* ops[0xF2] = */ "LD A,(ff00h+C)",
+	/* ops[0xF3] = */ "DI",
+	/* ops[0xF4] = */ "HANG",
+	/* ops[0xF5] = */ "PUSH AF",
+	/* ops[0xF6] = */ "OR A,$",
+	/* ops[0xF7] = */ "RST 48",
+	/* ops[0xF8] = */ "LD HL,SP+$",
+	/* ops[0xF9] = */ "LD SP,HL",
+	/* ops[0xFA] = */ "LD A,($)",
+	/* ops[0xFB] = */ "EI",
+	/* ops[0xFC] = */ "HANG",
+	/* ops[0xFD] = */ "HANG",
+	/* ops[0xFE] = */ "CP A,$",
+	/* ops[0xFF] = */ "RST 56"
+}};
+
+const gb::mnemonic_table gb::cb_opcode_mnemonics{{
+	/* cb[0x00] = */ "RLC B",
+	/* cb[0x01] = */ "RLC C",
+	/* cb[0x02] = */ "RLC D",
+	/* cb[0x03] = */ "RLC E",
+	/* cb[0x04] = */ "RLC H",
+	/* cb[0x05] = */ "RLC L",
+	/* cb[0x06] = */ "RLC (HL)",
+	/* cb[0x07] = */ "RLC A",
+	/* cb[0x08] = */ "RRC B",
+	/* cb[0x09] = */ "RRC C",
+	/* cb[0x0A] = */ "RRC D",
+	/* cb[0x0B] = */ "RRC E",
+	/* cb[0x0C] = */ "RRC H",
+	/* cb[0x0D] = */ "RRC L",
+	/* cb[0x0E] = */ "RRC (HL)",
+	/* cb[0x0F] = */ "RRC A",
+	/* cb[0x10] = */ "RL B",
+	/* cb[0x11] = */ "RL C",
+	/* cb[0x12] = */ "RL D",
+	/* cb[0x13] = */ "RL E",
+	/* cb[0x14] = */ "RL H",
+	/* cb[0x15] = */ "RL L",
+	/* cb[0x16] = */ "RL (HL)",
+	/* cb[0x17] = */ "RL A",
+	/* cb[0x18] = */ "RR B",
+	/* cb[0x19] = */ "RR C",
+	/* cb[0x1A] = */ "RR D",
+	/* cb[0x1B] = */ "RR E",
+	/* cb[0x1C] = */ "RR H",
+	/* cb[0x1D] = */ "RR L",
+	/* cb[0x1E] = */ "RR (HL)",
+	/* cb[0x1F] = */ "RR A",
+	/* cb[0x20] = */ "SLA B",
+	/* cb[0x21] = */ "SLA C",
+	/* cb[0x22] = */ "SLA D",
+	/* cb[0x23] = */ "SLA E",
+	/* cb[0x24] = */ "SLA H",
+	/* cb[0x25] = */ "SLA L",
+	/* cb[0x26] = */ "SLA (HL)",
+	/* cb[0x27] = */ "SLA A",
+	/* cb[0x28] = */ "SRA B",
+	/* cb[0x29] = */ "SRA C",
+	/* cb[0x2A] = */ "SRA D",
+	/* cb[0x2B] = */ "SRA E",
+	/* cb[0x2C] = */ "SRA H",
+	/* cb[0x2D] = */ "SRA L",
+	/* cb[0x2E] = */ "SRA (HL)",
+	/* cb[0x2F] = */ "SRA A",
+	/* cb[0x30] = */ "SWAP B",
+	/* cb[0x31] = */ "SWAP C",
+	/* cb[0x32] = */ "SWAP D",
+	/* cb[0x33] = */ "SWAP E",
+	/* cb[0x34] = */ "SWAP H",
+	/* cb[0x35] = */ "SWAP L",
+	/* cb[0x36] = */ "SWAP (HL)",
+	/* cb[0x37] = */ "SWAP A",
+	/* cb[0x38] = */ "SRL B",
+	/* cb[0x39] = */ "SRL C",
+	/* cb[0x3A] = */ "SRL D",
+	/* cb[0x3B] = */ "SRL E",
+	/* cb[0x3C] = */ "SRL H",
+	/* cb[0x3D] = */ "SRL L",
+	/* cb[0x3E] = */ "SRL (HL)",
+	/* cb[0x3F] = */ "SRL A",
+	/* cb[0x40] = */ "BIT 0,B",
+	/* cb[0x41] = */ "BIT 0,C",
+	/* cb[0x42] = */ "BIT 0,D",
+	/* cb[0x43] = */ "BIT 0,E",
+	/* cb[0x44] = */ "BIT 0,H",
+	/* cb[0x45] = */ "BIT 0,L",
+	/* cb[0x46] = */ "BIT 0,(HL)",
+	/* cb[0x47] = */ "BIT 0,A",
+	/* cb[0x48] = */ "BIT 1,B",
+	/* cb[0x49] = */ "BIT 1,C",
+	/* cb[0x4A] = */ "BIT 1,D",
+	/* cb[0x4B] = */ "BIT 1,E",
+	/* cb[0x4C] = */ "BIT 1,H",
+	/* cb[0x4D] = */ "BIT 1,L",
+	/* cb[0x4E] = */ "BIT 1,(HL)",
+	/* cb[0x4F] = */ "BIT 1,A",
+	/* cb[0x50] = */ "BIT 2,B",
+	/* cb[0x51] = */ "BIT 2,C",
+	/* cb[0x52] = */ "BIT 2,D",
+	/* cb[0x53] = */ "BIT 2,E",
+	/* cb[0x54] = */ "BIT 2,H",
+	/* cb[0x55] = */ "BIT 2,L",
+	/* cb[0x56] = */ "BIT 2,(HL)",
+	/* cb[0x57] = */ "BIT 2,A",
+	/* cb[0x58] = */ "BIT 3,B",
+	/* cb[0x59] = */ "BIT 3,C",
+	/* cb[0x5A] = */ "BIT 3,D",
+	/* cb[0x5B] = */ "BIT 3,E",
+	/* cb[0x5C] = */ "BIT 3,H",
+	/* cb[0x5D] = */ "BIT 3,L",
+	/* cb[0x5E] = */ "BIT 3,(HL)",
+	/* cb[0x5F] = */ "BIT 3,A",
+	/* cb[0x60] = */ "BIT 4,B",
+	/* cb[0x61] = */ "BIT 4,C",
+	/* cb[0x62] = */ "BIT 4,D",
+	/* cb[0x63] = */ "BIT 4,E",
+	/* cb[0x64] = */ "BIT 4,H",
+	/* cb[0x65] = */ "BIT 4,L",
+	/* cb[0x66] = */ "BIT 4,(HL)",
+	/* cb[0x67] = */ "BIT 4,A",
+	/* cb[0x68] = */ "BIT 5,B",
+	/* cb[0x69] = */ "BIT 5,C",
+	/* cb[0x6A] = */ "BIT 5,D",
+	/* cb[0x6B] = */ "BIT 5,E",
+	/* cb[0x6C] = */ "BIT 5,H",
+	/* cb[0x6D] = */ "BIT 5,L",
+	/* cb[0x6E] = */ "BIT 5,(HL)",
+	/* cb[0x6F] = */ "BIT 5,A",
+	/* cb[0x70] = */ "BIT 6,B",
+	/* cb[0x71] = */ "BIT 6,C",
+	/* cb[0x72] = */ "BIT 6,D",
+	/* cb[0x73] = */ "BIT 6,E",
+	/* cb[0x74] = */ "BIT 6,H",
+	/* cb[0x75] = */ "BIT 6,L",
+	/* cb[0x76] = */ "BIT 6,(HL)",
+	/* cb[0x77] = */ "BIT 6,A",
+	/* cb[0x78] = */ "BIT 7,B",
+	/* cb[0x79] = */ "BIT 7,C",
+	/* cb[0x7A] = */ "BIT 7,D",
+	/* cb[0x7B] = */ "BIT 7,E",
+	/* cb[0x7C] = */ "BIT 7,H",
+	/* cb[0x7D] = */ "BIT 7,L",
+	/* cb[0x7E] = */ "BIT 7,(HL)",
+	/* cb[0x7F] = */ "BIT 7,A",
+	/* cb[0x80] = */ "RES 0,B",
+	/* cb[0x81] = */ "RES 0,C",
+	/* cb[0x82] = */ "RES 0,D",
+	/* cb[0x83] = */ "RES 0,E",
+	/* cb[0x84] = */ "RES 0,H",
+	/* cb[0x85] = */ "RES 0,L",
+	/* cb[0x86] = */ "RES 0,(HL)",
+	/* cb[0x87] = */ "RES 0,A",
+	/* cb[0x88] = */ "RES 1,B",
+	/* cb[0x89] = */ "RES 1,C",
+	/* cb[0x8A] = */ "RES 1,D",
+	/* cb[0x8B] = */ "RES 1,E",
+	/* cb[0x8C] = */ "RES 1,H",
+	/* cb[0x8D] = */ "RES 1,L",
+	/* cb[0x8E] = */ "RES 1,(HL)",
+	/* cb[0x8F] = */ "RES 1,A",
+	/* cb[0x90] = */ "RES 2,B",
+	/* cb[0x91] = */ "RES 2,C",
+	/* cb[0x92] = */ "RES 2,D",
+	/* cb[0x93] = */ "RES 2,E",
+	/* cb[0x94] = */ "RES 2,H",
+	/* cb[0x95] = */ "RES 2,L",
+	/* cb[0x96] = */ "RES 2,(HL)",
+	/* cb[0x97] = */ "RES 2,A",
+	/* cb[0x98] = */ "RES 3,B",
+	/* cb[0x99] = */ "RES 3,C",
+	/* cb[0x9A] = */ "RES 3,D",
+	/* cb[0x9B] = */ "RES 3,E",
+	/* cb[0x9C] = */ "RES 3,H",
+	/* cb[0x9D] = */ "RES 3,L",
+	/* cb[0x9E] = */ "RES 3,(HL)",
+	/* cb[0x9F] = */ "RES 3,A",
+	/* cb[0xA0] = */ "RES 4,B",
+	/* cb[0xA1] = */ "RES 4,C",
+	/* cb[0xA2] = */ "RES 4,D",
+	/* cb[0xA3] = */ "RES 4,E",
+	/* cb[0xA4] = */ "RES 4,H",
+	/* cb[0xA5] = */ "RES 4,L",
+	/* cb[0xA6] = */ "RES 4,(HL)",
+	/* cb[0xA7] = */ "RES 4,A",
+	/* cb[0xA8] = */ "RES 5,B",
+	/* cb[0xA9] = */ "RES 5,C",
+	/* cb[0xAA] = */ "RES 5,D",
+	/* cb[0xAB] = */ "RES 5,E",
+	/* cb[0xAC] = */ "RES 5,H",
+	/* cb[0xAD] = */ "RES 5,L",
+	/* cb[0xAE] = */ "RES 5,(HL)",
+	/* cb[0xAF] = */ "RES 5,A",
+	/* cb[0xB0] = */ "RES 6,B",
+	/* cb[0xB1] = */ "RES 6,C",
+	/* cb[0xB2] = */ "RES 6,D",
+	/* cb[0xB3] = */ "RES 6,E",
+	/* cb[0xB4] = */ "RES 6,H",
+	/* cb[0xB5] = */ "RES 6,L",
+	/* cb[0xB6] = */ "RES 6,(HL)",
+	/* cb[0xB7] = */ "RES 6,A",
+	/* cb[0xB8] = */ "RES 7,B",
+	/* cb[0xB9] = */ "RES 7,C",
+	/* cb[0xBA] = */ "RES 7,D",
+	/* cb[0xBB] = */ "RES 7,E",
+	/* cb[0xBC] = */ "RES 7,H",
+	/* cb[0xBD] = */ "RES 7,L",
+	/* cb[0xBE] = */ "RES 7,(HL)",
+	/* cb[0xBF] = */ "RES 7,A",
+	/* cb[0xC0] = */ "SET 0,B",
+	/* cb[0xC1] = */ "SET 0,C",
+	/* cb[0xC2] = */ "SET 0,D",
+	/* cb[0xC3] = */ "SET 0,E",
+	/* cb[0xC4] = */ "SET 0,H",
+	/* cb[0xC5] = */ "SET 0,L",
+	/* cb[0xC6] = */ "SET 0,(HL)",
+	/* cb[0xC7] = */ "SET 0,A",
+	/* cb[0xC8] = */ "SET 1,B",
+	/* cb[0xC9] = */ "SET 1,C",
+	/* cb[0xCA] = */ "SET 1,D",
+	/* cb[0xCB] = */ "SET 1,E",
+	/* cb[0xCC] = */ "SET 1,H",
+	/* cb[0xCD] = */ "SET 1,L",
+	/* cb[0xCE] = */ "SET 1,(HL)",
+	/* cb[0xCF] = */ "SET 1,A",
+	/* cb[0xD0] = */ "SET 2,B",
+	/* cb[0xD1] = */ "SET 2,C",
+	/* cb[0xD2] = */ "SET 2,D",
+	/* cb[0xD3] = */ "SET 2,E",
+	/* cb[0xD4] = */ "SET 2,H",
+	/* cb[0xD5] = */ "SET 2,L",
+	/* cb[0xD6] = */ "SET 2,(HL)",
+	/* cb[0xD7] = */ "SET 2,A",
+	/* cb[0xD8] = */ "SET 3,B",
+	/* cb[0xD9] = */ "SET 3,C",
+	/* cb[0xDA] = */ "SET 3,D",
+	/* cb[0xDB] = */ "SET 3,E",
+	/* cb[0xDC] = */ "SET 3,H",
+	/* cb[0xDD] = */ "SET 3,L",
+	/* cb[0xDE] = */ "SET 3,(HL)",
+	/* cb[0xDF] = */ "SET 3,A",
+	/* cb[0xE0] = */ "SET 4,B",
+	/* cb[0xE1] = */ "SET 4,C",
+	/* cb[0xE2] = */ "SET 4,D",
+	/* cb[0xE3] = */ "SET 4,E",
+	/* cb[0xE4] = */ "SET 4,H",
+	/* cb[0xE5] = */ "SET 4,L",
+	/* cb[0xE6] = */ "SET 4,(HL)",
+	/* cb[0xE7] = */ "SET 4,A",
+	/* cb[0xE8] = */ "SET 5,B",
+	/* cb[0xE9] = */ "SET 5,C",
+	/* cb[0xEA] = */ "SET 5,D",
+	/* cb[0xEB] = */ "SET 5,E",
+	/* cb[0xEC] = */ "SET 5,H",
+	/* cb[0xED] = */ "SET 5,L",
+	/* cb[0xEE] = */ "SET 5,(HL)",
+	/* cb[0xEF] = */ "SET 5,A",
+	/* cb[0xF0] = */ "SET 6,B",
+	/* cb[0xF1] = */ "SET 6,C",
+	/* cb[0xF2] = */ "SET 6,D",
+	/* cb[0xF3] = */ "SET 6,E",
+	/* cb[0xF4] = */ "SET 6,H",
+	/* cb[0xF5] = */ "SET 6,L",
+	/* cb[0xF6] = */ "SET 6,(HL)",
+	/* cb[0xF7] = */ "SET 6,A",
+	/* cb[0xF8] = */ "SET 7,B",
+	/* cb[0xF9] = */ "SET 7,C",
+	/* cb[0xFA] = */ "SET 7,D",
+	/* cb[0xFB] = */ "SET 7,E",
+	/* cb[0xFC] = */ "SET 7,H",
+	/* cb[0xFD] = */ "SET 7,L",
+	/* cb[0xFE] = */ "SET 7,(HL)",
+	/* cb[0xFF] = */ "SET 7,A"
+}};
+
+const char *gb::mnemonic(const opcode *op)
+{
+	ASSERT(op != nullptr);
+	if (opcodes.data() <= op && op < opcodes.data() + opcodes.size())
+		return opcode_mnemonics[op - opcodes.data()];
+	ASSERT(cb_opcodes.data() <= op && op < cb_opcodes.data() + cb_opcodes.size());
+	return cb_opcode_mnemonics[op - cb_opcodes.data()];
+}
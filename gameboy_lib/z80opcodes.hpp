@@ -1,7 +1,8 @@
 #pragma once
 #include "assert.hpp"
-#include <string>
 #include <array>
+#include <cstdint>
+#include <type_traits>
 
 namespace gb
 {
@@ -9,38 +10,52 @@ class z80_cpu;
 
 struct opcode
 {
-	using code = void (*)(z80_cpu &cpu);
-
-	opcode(std::string mnemonic, int extra_bytes, int cycles, code base_code, int jump_cycles=0,
-			code read_code=nullptr, code write_code=nullptr) :
-		extra_bytes(extra_bytes),
-		cycles(cycles),
-		jump_cycles(jump_cycles),
-		base_code(base_code == nullptr ? &noop : base_code),
-		read_code(read_code),
-		write_code(write_code),
-		mnemonic(std::move(mnemonic))
+	/** Simulation steps of the CPU (see z80_cpu) an opcode can execute code in. */
+	enum step : uint8_t
 	{
-		ASSERT(cycles >= 0);
-		ASSERT(jump_cycles >= 0);
+		base = 1 << 0,   // taxed `cycles` cycles, if the PC changed `jump_cycles` cycles are taxed as well
+		read = 1 << 1,   // taxed 1 cycle
+		write = 1 << 2,  // taxed 1 cycle
+	};
+
+	using code = void (*)(z80_cpu &cpu, step current);
+
+	constexpr opcode(int extra_bytes, int cycles, code execute, int steps=step::base, int jump_cycles=0) :
+		execute(execute),
+		extra_bytes(static_cast<uint8_t>(extra_bytes)),
+		cycles(static_cast<uint8_t>(cycles)),
+		jump_cycles(static_cast<uint8_t>(jump_cycles)),
+		steps(static_cast<uint8_t>(steps))
+	{
+		ASSERT(execute != nullptr);
+		ASSERT(0 <= cycles && cycles <= 0xFF);
+		ASSERT(0 <= jump_cycles && jump_cycles <= 0xFF);
 		ASSERT(0 <= extra_bytes && extra_bytes <= 2);
+		ASSERT(steps != 0 && (steps & ~(step::base | step::read | step::write)) == 0);
 	}
 
-	const int extra_bytes;
-	const int cycles;
-	const int jump_cycles;
-	const code base_code;  // base code, always executed, taxed `cycles` cycles
-	                       // if the PC changed `jump_cycles` cycles are taxed as well
-	const code read_code;  // read code, taxed 1 cycle if != nullptr
-	const code write_code;  // write code, taxed 1 cycle if != nullptr
-	const std::string mnemonic;
-
-private:
-	static void noop(z80_cpu &) {}
+	bool has_step(step s) const { return (steps & s) != 0; }
+
+	code execute;  // called once for every step in `steps`
+	uint8_t extra_bytes;
+	uint8_t cycles;
+	uint8_t jump_cycles;
+	uint8_t steps;
 };
 
+// The dispatch tables are hot, keep them dense.
+static_assert(sizeof(opcode) <= 16, "opcode is too big");
+static_assert(std::is_trivially_copyable<opcode>::value, "opcode must be trivially copyable");
+static_assert(std::is_standard_layout<opcode>::value, "opcode must have standard layout");
+
 using opcode_table = std::array<const opcode, 0x100>;
 extern const opcode_table opcodes;
 extern const opcode_table cb_opcodes;
 
+/** Mnemonics for the disassembler and debug output, kept separately from the dispatch tables. */
+using mnemonic_table = std::array<const char *, 0x100>;
+extern const mnemonic_table opcode_mnemonics;
+extern const mnemonic_table cb_opcode_mnemonics;
+const char *mnemonic(const opcode *op);
+
 }
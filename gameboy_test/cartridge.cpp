@@ -0,0 +1,188 @@
+#include "cart_mbc1.hpp"
+#include "cart_mbc2.hpp"
+#include "cart_mbc3.hpp"
+#include "cart_mbc5.hpp"
+#include "cart_ram.hpp"
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+using gb::cputime;
+
+namespace
+{
+
+/** ROM with the given banks of 16 KB, each filled with its bank number. */
+gb::rom make_rom(uint8_t cartridge, size_t banks, uint8_t raw_ram_size)
+{
+	std::vector<uint8_t> data(banks * 0x4000);
+	for (size_t i = 0; i < data.size(); ++i)
+		data[i] = static_cast<uint8_t>(i / 0x4000);
+	data[0x147] = cartridge;
+	data[0x148] = 0;
+	data[0x149] = raw_ram_size;
+	return gb::rom(std::move(data));
+}
+
+uint8_t read(const gb::memory_mapping &cart, uint16_t addr)
+{
+	uint8_t value = 0;
+	BOOST_REQUIRE(cart.read8(addr, value));
+	return value;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_cartridge_mbc1_banks_wrap)
+{
+	gb::cart_mbc1 cart(make_rom(0x01, 4, 0x00));
+	cart.write8(0x2000, 0x06);  // wraps to 2
+	BOOST_CHECK_EQUAL(read(cart, 0x4000), 2);
+	cart.write8(0x4000, 0x01);  // bank 0x26 wraps to 2 as well
+	BOOST_CHECK_EQUAL(read(cart, 0x7FFF), 2);
+	const uint8_t *page = nullptr;
+	BOOST_REQUIRE(cart.read_page(0x4100, page));
+	BOOST_REQUIRE(page != nullptr);
+	BOOST_CHECK_EQUAL(page[0], 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_cartridge_mbc3_banks_and_rtc)
+{
+	cputime clock(0);
+	gb::cart_mbc3 cart(make_rom(0x10, 8, 0x03), clock, true);
+	cart.write8(0x0000, 0x0A);
+
+	cart.write8(0x2000, 0x00);
+	BOOST_CHECK_EQUAL(read(cart, 0x4000), 1);
+	cart.write8(0x2000, 0x0B);  // wraps to 3
+	BOOST_CHECK_EQUAL(read(cart, 0x7FFF), 3);
+	BOOST_CHECK_EQUAL(cart.rom_bank(), 0x0B);
+
+	cart.write8(0x4000, 0x02);
+	cart.write8(0xA123, 0x42);
+	cart.write8(0x4000, 0x00);
+	BOOST_CHECK_EQUAL(read(cart, 0xA123), 0);
+	cart.write8(0x4000, 0x02);
+	BOOST_CHECK_EQUAL(read(cart, 0xA123), 0x42);
+
+	// 1 day, 2 hours, 3 minutes and 4.5 seconds
+	clock += std::chrono::hours(26) + std::chrono::minutes(3) + std::chrono::seconds(4) + cputime(8388608 / 2);
+	cart.write8(0x6000, 0x00);
+	cart.write8(0x6000, 0x01);
+	clock += std::chrono::hours(1);  // not latched
+	const uint8_t expected[] = {4, 3, 2, 1, 0};
+	for (uint8_t i = 0; i < 5; ++i)
+	{
+		cart.write8(0x4000, 0x08 + i);
+		BOOST_CHECK_EQUAL(read(cart, 0xA000), expected[i]);
+	}
+
+	// Halt, set the seconds and check that the clock doesn't run
+	cart.write8(0x4000, 0x0C);
+	cart.write8(0xA000, gb::cart_mbc3::rtc_halt_mask);
+	cart.write8(0x4000, 0x08);
+	cart.write8(0xA000, 30);
+	clock += std::chrono::minutes(10);
+	cart.write8(0x6000, 0x00);
+	cart.write8(0x6000, 0x01);
+	BOOST_CHECK_EQUAL(read(cart, 0xA000), 30);
+	cart.write8(0x4000, 0x09);
+	BOOST_CHECK_EQUAL(read(cart, 0xA000), 3);
+	cart.write8(0x4000, 0x0C);
+	BOOST_CHECK_EQUAL(read(cart, 0xA000), gb::cart_mbc3::rtc_halt_mask);
+
+	// Run for 512 days: the day counter overflows into the carry
+	cart.write8(0xA000, 0x00);
+	clock += std::chrono::hours(24 * 512);
+	cart.write8(0x6000, 0x00);
+	cart.write8(0x6000, 0x01);
+	BOOST_CHECK_EQUAL(read(cart, 0xA000), gb::cart_mbc3::rtc_carry_mask);
+	cart.write8(0x4000, 0x0B);
+	BOOST_CHECK_EQUAL(read(cart, 0xA000), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_cartridge_mbc2_ram)
+{
+	gb::cart_mbc2 cart(make_rom(0x05, 4, 0x00));
+	cart.write8(0x0000, 0x0A);
+	cart.write8(0xA010, 0x5A);
+	BOOST_CHECK_EQUAL(read(cart, 0xA010), 0xFA);
+	BOOST_CHECK_EQUAL(read(cart, 0xA210), 0xFA);  // mirrored every 512 byte
+
+	cart.write8(0x2100, 0x02);
+	BOOST_CHECK_EQUAL(read(cart, 0x4000), 2);
+	cart.write8(0x2000, 0x03);  // address bit 8 clear: RAM enable, not the bank
+	BOOST_CHECK_EQUAL(read(cart, 0x4000), 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_cartridge_mbc5_rumble)
+{
+	gb::cart_mbc5 cart(make_rom(0x1D, 4, 0x03), std::string(), true);
+	cart.write8(0x0000, 0x0A);
+	cart.write8(0xA000, 0x11);
+	cart.write8(0x4000, 0x08);
+	BOOST_CHECK(cart.rumble());
+	BOOST_CHECK_EQUAL(read(cart, 0xA000), 0x11);  // bit 3 doesn't select a bank
+	cart.write8(0x4000, 0x01);
+	BOOST_CHECK(!cart.rumble());
+	BOOST_CHECK_EQUAL(read(cart, 0xA000), 0x00);
+
+	cart.write8(0x2000, 0x06);  // wraps to 2
+	const uint8_t *page = nullptr;
+	BOOST_REQUIRE(cart.read_page(0x4100, page));
+	BOOST_CHECK_EQUAL(page[0], 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_cart_ram_save_file)
+{
+	const std::string path = "test_cart_ram.sav";
+	auto read_file = [&path]() {
+		std::ifstream in(path, std::ios::binary);
+		return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	};
+	auto write_file = [&path](const std::vector<uint8_t> &data) {
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+	};
+	std::remove(path.c_str());
+
+	{
+		gb::cart_ram ram(0x2000, path);
+		BOOST_REQUIRE(ram.battery());
+		for (size_t i = 0; i < ram.size(); ++i)
+			ram.write(i, static_cast<uint8_t>(i * 7));
+	}
+	BOOST_CHECK_EQUAL(read_file().size(), 0x2000u);
+	{
+		gb::cart_ram ram(0x2000, path);
+		for (size_t i = 0; i < ram.size(); ++i)
+			BOOST_REQUIRE_EQUAL(ram[i], static_cast<uint8_t>(i * 7));
+	}
+
+	// a shorter file is grown
+	write_file(std::vector<uint8_t>(0x100, 0x11));
+	{
+		gb::cart_ram ram(0x2000, path);
+		BOOST_CHECK_EQUAL(ram[0xFF], 0x11);
+		BOOST_CHECK_EQUAL(ram[0x100], 0x00);
+	}
+	BOOST_CHECK_EQUAL(read_file().size(), 0x2000u);
+
+	// the tail of a longer file is kept
+	std::vector<uint8_t> data(0x2000, 0x11);
+	data.insert(data.end(), 0x30, 0xAB);
+	write_file(data);
+	{
+		gb::cart_ram ram(0x2000, path);
+		BOOST_CHECK_EQUAL(ram[0x1FFF], 0x11);
+		ram.write(0x1FFF, 0x22);
+		ram.flush();
+	}
+	data[0x1FFF] = 0x22;
+	const auto saved = read_file();
+	BOOST_CHECK_EQUAL_COLLECTIONS(saved.begin(), saved.end(), data.begin(), data.end());
+
+	std::remove(path.c_str());
+}
@@ -0,0 +1,42 @@
+#include "compositor.hpp"
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(test_compositor_priorities)
+{
+	// bg: color 2 palette 1 / color 0 / color 1 with priority; obj: color 3 palette 2 (behind bg)
+	const uint8_t bg[] = {0x06, 0x06, 0x00, 0x00, 0x81, 0x81, 0x06};
+	const uint8_t obj[] = {0x00, 0x0B, 0x0B, 0x8B, 0x0B, 0x00, 0x8B};
+	const uint8_t expected[] = {0x06, 0x2B, 0x2B, 0x2B, 0x01, 0x01, 0x06};
+	uint8_t out[7];
+	gb::compose_line(gb::simd::none, bg, obj, out, 7);
+	for (size_t x = 0; x < 7; ++x)
+		BOOST_CHECK_EQUAL(out[x], expected[x]);
+}
+
+BOOST_AUTO_TEST_CASE(test_compositor_simd_matches_scalar)
+{
+	// every combination of a bg and an obj pixel, with a length which isn't a multiple of 32
+	std::vector<uint8_t> bg, obj;
+	for (int b = 0; b < 256; ++b)
+	{
+		for (int o = 0; o < 256; ++o)
+		{
+			bg.push_back(static_cast<uint8_t>(b));
+			obj.push_back(static_cast<uint8_t>(o));
+		}
+	}
+	const auto count = bg.size() - 7;
+
+	std::vector<uint8_t> expected(count), out(count);
+	gb::compose_line(gb::simd::none, bg.data(), obj.data(), expected.data(), count);
+
+	const auto best = gb::detect_simd();
+	for (auto level : {gb::simd::sse2, gb::simd::avx2})
+	{
+		if (static_cast<int>(level) > static_cast<int>(best))
+			continue;
+		gb::compose_line(level, bg.data(), obj.data(), out.data(), count);
+		BOOST_CHECK(out == expected);
+	}
+}
@@ -0,0 +1,206 @@
+#include "gb_thread.hpp"
+#include <boost/test/unit_test.hpp>
+#include <initializer_list>
+#include <vector>
+
+using gb::cputime;
+
+namespace
+{
+
+std::vector<uint8_t> rom_data()
+{
+	return std::vector<uint8_t>(0x8000, 0x00);
+}
+
+void put(std::vector<uint8_t> &data, uint16_t addr, std::initializer_list<uint8_t> code)
+{
+	std::copy(code.begin(), code.end(), data.begin() + addr);
+}
+
+/** One instruction, or 4 clocks while halted, without skipping anything. */
+void step_exactly(gb::gb_hardware &hw)
+{
+	auto &cpu = *hw.cpu;
+	const auto time_fde = cpu.fetch_decode_execute();
+	hw.timer.tick(cpu, time_fde);
+	const auto time_r = cpu.read();
+	hw.timer.tick(cpu, time_r);
+	const auto time_w = cpu.write();
+	hw.timer.tick(cpu, time_w);
+	const auto time = time_fde + time_r + time_w;
+	hw.video.tick(cpu, time);
+	BOOST_REQUIRE(hw.video.take_cpu_stall() == cputime(0));
+	hw.elapsed += time;
+}
+
+/** Interrupt vectors of vblank, lcdc and timer jump to a handler logging DIV, LY and TIMA at (DE++). */
+void put_logging_handlers(std::vector<uint8_t> &data)
+{
+	put(data, 0x40, {0xC3, 0x00, 0x02});
+	put(data, 0x48, {0xC3, 0x00, 0x02});
+	put(data, 0x50, {0xC3, 0x00, 0x02});
+	put(data, 0x200, {
+		0xF5,              // push af
+		0xF0, 0x04, 0x12, 0x13,  // ld a,(DIV)  ld (de),a  inc de
+		0xF0, 0x44, 0x12, 0x13,  // ld a,(LY)  ld (de),a  inc de
+		0xF0, 0x05, 0x12, 0x13,  // ld a,(TIMA)  ld (de),a  inc de
+		0xF1,              // pop af
+		0xD9});            // reti
+}
+
+struct lockstep_result
+{
+	int ticks;
+	int steps;
+};
+
+/**
+ * Runs fast with gb_hardware::tick and exact in single steps to the same time until fast
+ * reached the frame, the registers must be the same after every tick and WRAM at the end.
+ */
+lockstep_result run_lockstep(gb::gb_hardware &fast, gb::gb_hardware &exact, uint64_t frame)
+{
+	using r = gb::register16;
+	lockstep_result result{0, 0};
+	while (fast.video.frames() < frame)
+	{
+		fast.tick();
+		++result.ticks;
+		while (exact.elapsed < fast.elapsed)
+		{
+			step_exactly(exact);
+			++result.steps;
+		}
+
+		const auto &a = fast.cpu->registers();
+		const auto &b = exact.cpu->registers();
+		if (exact.elapsed != fast.elapsed || a.read16<r::af>() != b.read16<r::af>()
+			|| a.read16<r::pc>() != b.read16<r::pc>() || a.read16<r::de>() != b.read16<r::de>())
+		{
+			BOOST_REQUIRE_EQUAL(exact.elapsed.count(), fast.elapsed.count());
+			BOOST_REQUIRE_EQUAL(a.read16<r::pc>(), b.read16<r::pc>());
+			BOOST_REQUIRE_EQUAL(a.read16<r::af>(), b.read16<r::af>());
+			BOOST_REQUIRE_EQUAL(a.read16<r::de>(), b.read16<r::de>());
+		}
+	}
+
+	for (uint16_t addr = 0xC000; addr < 0xE000; ++addr)
+	{
+		if (fast.cpu->memory().read8(addr) != exact.cpu->memory().read8(addr))
+		{
+			BOOST_REQUIRE_EQUAL(fast.cpu->memory().read8(addr), exact.cpu->memory().read8(addr));
+		}
+	}
+	return result;
+}
+
+/** Steps the ROM exactly and returns true if the CPU reported an idle loop. */
+bool finds_idle_loop(gb::gb_hardware &hw, int steps)
+{
+	gb::z80_cpu::idle_loop loop;
+	for (int i = 0; i < steps; ++i)
+	{
+		step_exactly(hw);
+		if (hw.cpu->take_idle_loop(loop))
+			return true;
+	}
+	return false;
+}
+
+bool finds_idle_loop(std::initializer_list<uint8_t> code)
+{
+	auto data = rom_data();
+	put(data, 0x100, code);
+	gb::gb_hardware hw{gb::rom(data)};
+	return finds_idle_loop(hw, 1000);
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_gb_hardware_idle_loop_xor)
+{
+	// ld a,2 / xor 1 / jr nz,-4: without a read at the start A toggles on every iteration
+	auto data = rom_data();
+	put(data, 0x100, {0x3E, 0x02, 0xEE, 0x01, 0x20, 0xFC});
+	gb::gb_hardware fast{gb::rom(data)}, exact{gb::rom(data)};
+	run_lockstep(fast, exact, 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_gb_hardware_idle_loop_polling)
+{
+	// Polls LY, STAT, DIV and TIMA in turn while vblank, LYC and timer interrupts are logged.
+	auto data = rom_data();
+	put_logging_handlers(data);
+	put(data, 0x100, {
+		0x11, 0x00, 0xC0,        // ld de,C000h
+		0x3E, 0x50, 0xE0, 0x45,  // LYC = 80
+		0x3E, 0x40, 0xE0, 0x41,  // STAT = LYC interrupt
+		0x3E, 0x04, 0xE0, 0x07,  // TAC = 4096 Hz
+		0x3E, 0x07, 0xE0, 0xFF,  // IE = vblank, lcdc, timer
+		0xFB,                    // ei
+		0xF0, 0x44, 0xFE, 0x90, 0x20, 0xFA,  // 114: wait for LY = 144
+		0xF0, 0x41, 0xE6, 0x03, 0x20, 0xFA,  // wait for mode 0
+		0xF0, 0x04, 0xE6, 0x80, 0x28, 0xFA,  // wait for DIV bit 7 set
+		0xF0, 0x04, 0xE6, 0x80, 0x20, 0xFA,  // wait for DIV bit 7 reset
+		0xF0, 0x05, 0xFE, 0x00, 0x20, 0xFA,  // wait for TIMA = 0
+		0x18, 0xE0});                        // jr 114h
+	gb::gb_hardware fast{gb::rom(data)}, exact{gb::rom(data)};
+	const auto result = run_lockstep(fast, exact, 30);
+
+	BOOST_CHECK_GT(fast.cpu->registers().read16<gb::register16::de>(), 0xC000 + 3 * 60);
+	BOOST_CHECK_LT(result.ticks * 2, result.steps);
+}
+
+BOOST_AUTO_TEST_CASE(test_gb_hardware_idle_loop_rejected)
+{
+	BOOST_CHECK(finds_idle_loop({0xF0, 0x44, 0xFE, 0x90, 0x20, 0xFA}));    // ld a,(LY)  cp 144  jr nz
+	BOOST_CHECK(!finds_idle_loop({0xF0, 0x44, 0xE0, 0x80, 0x18, 0xFA}));   // ld a,(LY)  ld (ff80h),a  jr
+	BOOST_CHECK(!finds_idle_loop({0xFA, 0x00, 0xC0, 0xFE, 0x01, 0x20, 0xF9}));  // ld a,(c000h)  cp 1  jr nz
+	BOOST_CHECK(!finds_idle_loop({0xF0, 0x00, 0xE6, 0x0F, 0x20, 0xFA}));   // ld a,(P1)  and 0fh  jr nz
+}
+
+BOOST_AUTO_TEST_CASE(test_gb_hardware_idle_loop_not_decoded_again)
+{
+	// ld a,(c100h)  cp 1  jr nz in WRAM is rejected, the same loop start and jump isn't decoded
+	// again even after the code was changed to poll LY.
+	auto data = rom_data();
+	const std::initializer_list<uint8_t> rejected{0xFA, 0x00, 0xC1, 0xFE, 0x01, 0x20, 0xF9};
+	const std::initializer_list<uint8_t> polling{0xFA, 0x44, 0xFF, 0xFE, 0xFF, 0x20, 0xF9};
+	auto load = [](gb::gb_hardware &hw, std::initializer_list<uint8_t> code) {
+		uint16_t addr = 0xC000;
+		for (auto byte : code)
+			hw.cpu->memory().write8(addr++, byte);
+		hw.cpu->registers().write16<gb::register16::pc>(0xC000);
+	};
+
+	gb::gb_hardware hw{gb::rom(data)};
+	load(hw, rejected);
+	BOOST_CHECK(!finds_idle_loop(hw, 100));
+	load(hw, polling);
+	BOOST_CHECK(!finds_idle_loop(hw, 1000));
+
+	gb::gb_hardware fresh{gb::rom(data)};
+	load(fresh, polling);
+	BOOST_CHECK(finds_idle_loop(fresh, 1000));
+}
+
+BOOST_AUTO_TEST_CASE(test_gb_hardware_halt)
+{
+	// Halts until the next vblank or timer interrupt, which are logged.
+	auto data = rom_data();
+	put_logging_handlers(data);
+	put(data, 0x100, {
+		0x11, 0x00, 0xC0,        // ld de,C000h
+		0x3E, 0x00, 0xE0, 0x06,  // TMA = 0
+		0x3E, 0x05, 0xE0, 0x07,  // TAC = 262144 Hz
+		0x3E, 0x05, 0xE0, 0xFF,  // IE = vblank, timer
+		0xFB,                    // ei
+		0x76,                    // 110: halt
+		0x18, 0xFD});            // jr 110h
+	gb::gb_hardware fast{gb::rom(data)}, exact{gb::rom(data)};
+	const auto result = run_lockstep(fast, exact, 30);
+
+	BOOST_CHECK_GT(fast.cpu->registers().read16<gb::register16::de>(), 0xC000 + 3 * 30 * 18);
+	BOOST_CHECK_LT(result.ticks * 10, result.steps);
+}
@@ -0,0 +1,75 @@
+#include "gb_thread.hpp"
+#include "input_movie.hpp"
+#include <boost/test/unit_test.hpp>
+#include <sstream>
+
+using gb::cputime;
+
+namespace
+{
+
+gb::rom make_rom()
+{
+	return gb::rom(std::vector<uint8_t>(0x8000, 0x00));  // ROM only, NOPs
+}
+
+bool a_pressed(gb::gb_hardware &hw)
+{
+	hw.cpu->memory().write8(0xFF00, gb::joypad::direction_keys_bit);  // select the buttons
+	return (hw.cpu->memory().read8(0xFF00) & 0x01) == 0;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_input_movie_file)
+{
+	gb::input_movie movie;
+	movie.add({cputime(100), gb::key::start, true});
+	movie.add({cputime(100), gb::key::left, true});
+	movie.add({cputime(123456789), gb::key::start, false});
+
+	std::stringstream file;
+	movie.write(file);
+	gb::input_movie read;
+	read.read(file);
+	BOOST_REQUIRE_EQUAL(read.events().size(), 3);
+	BOOST_CHECK(read.events()[1].time == cputime(100));
+	BOOST_CHECK(read.events()[1].key == gb::key::left);
+	BOOST_CHECK(read.events()[2].time == cputime(123456789));
+	BOOST_CHECK(!read.events()[2].pressed);
+
+	std::stringstream invalid("gbmovie 1\n200 start down\n100 start up\n");
+	BOOST_CHECK_THROW(read.read(invalid), gb::input_movie_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_input_movie_record_and_play)
+{
+	gb::input_movie movie;
+	cputime pressed_at;
+	{
+		gb::gb_hardware hw(make_rom());
+		hw.record(&movie);
+		while (hw.elapsed < cputime(5000))
+			hw.tick();
+		pressed_at = hw.elapsed;
+		hw.key_down(gb::key::a);
+		hw.tick();
+		hw.key_up(gb::key::a);
+	}
+	BOOST_REQUIRE_EQUAL(movie.events().size(), 2);
+	BOOST_CHECK(movie.events()[0].time == pressed_at);
+
+	// The key changes at the same instruction boundary, live keys are ignored
+	gb::gb_hardware hw(make_rom());
+	hw.play(&movie);
+	hw.key_down(gb::key::a);
+	while (hw.elapsed < pressed_at)
+	{
+		hw.tick();
+		BOOST_CHECK(!a_pressed(hw));
+	}
+	hw.tick();
+	BOOST_CHECK(a_pressed(hw));
+	hw.tick();
+	BOOST_CHECK(!a_pressed(hw));
+}
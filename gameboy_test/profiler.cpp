@@ -0,0 +1,58 @@
+#include "profiler.hpp"
+#include "z80.hpp"
+#include "cart_mbc1.hpp"
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <csignal>
+#include <sstream>
+
+#ifdef __linux__
+
+BOOST_AUTO_TEST_CASE(test_profiler_samples)
+{
+	std::vector<uint8_t> data(4 * 0x4000, 0x00);
+	data[0x147] = 0x01;  // MBC1
+	gb::cart_mbc1 cart{gb::rom(std::move(data))};
+	cart.write8(0x2000, 3);
+	gb::z80_cpu cpu{gb::memory_map(), gb::register_file()};
+	cpu.registers().write16<gb::register16::pc>(0x4321);
+
+	struct sigaction before = {};
+	sigaction(SIGPROF, nullptr, &before);
+
+	gb::profiler profiler;
+	{
+		const gb::profiler::scope scope(gb::profiler::subsystem::cpu);
+		BOOST_REQUIRE(profiler.start(cpu, cart, std::chrono::microseconds(500)));
+		// burns CPU time of this thread, the timer doesn't count sleeping
+		const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+		volatile uint64_t work = 0;
+		while (std::chrono::steady_clock::now() < end)
+			work = work + 1;
+		profiler.stop();
+	}
+
+	// the SIGPROF handler is restored
+	struct sigaction after = {};
+	sigaction(SIGPROF, nullptr, &after);
+	BOOST_CHECK(after.sa_handler == before.sa_handler);
+
+	const auto profile = profiler.report();
+	BOOST_CHECK_GT(profile.samples, 10u);
+	BOOST_CHECK_EQUAL(profile.dropped, 0u);
+	BOOST_CHECK_EQUAL(profile.subsystems[static_cast<size_t>(gb::profiler::subsystem::cpu)], profile.samples);
+	BOOST_REQUIRE_EQUAL(profile.hotspots.size(), 1u);
+	BOOST_CHECK_EQUAL(profile.hotspots[0].bank, 3);
+	BOOST_CHECK_EQUAL(profile.hotspots[0].pc, 0x4321);
+	BOOST_CHECK_EQUAL(profile.hotspots[0].samples, profile.samples);
+
+	std::ostringstream text;
+	gb::profiler::print(text, profile);
+	BOOST_CHECK_NE(text.str().find("cpu 100.0 %"), std::string::npos);
+	BOOST_CHECK_NE(text.str().find("03:4321  100.0 %"), std::string::npos);
+
+	// the samples are only reported once
+	BOOST_CHECK_EQUAL(profiler.report().samples, 0u);
+}
+
+#endif
@@ -0,0 +1,151 @@
+#include "gb_thread.hpp"
+#include "state_hash.hpp"
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <initializer_list>
+#include <vector>
+
+namespace
+{
+
+/** ROM which runs the program at 100. */
+gb::rom make_rom(std::initializer_list<uint8_t> program)
+{
+	std::vector<uint8_t> data(0x8000, 0x00);
+	std::copy(program.begin(), program.end(), data.begin() + 0x100);
+	return gb::rom(std::move(data));
+}
+
+/** The lines of an rgb888 frame. */
+std::vector<uint8_t> frame_bytes(const gb::framebuffer &frame)
+{
+	std::vector<uint8_t> bytes;
+	for (int y = 0; y < gb::video::height; ++y)
+		bytes.insert(bytes.end(), frame.line(y), frame.line(y) + gb::video::width * 3);
+	return bytes;
+}
+
+void run_frames(gb::gb_hardware &hw, int count)
+{
+	const auto end = hw.video.frames() + count;
+	while (hw.video.frames() < end)
+		hw.tick();
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_save_state_replay)
+{
+	// Counts in WRAM at C000 and copies the count to the scroll: ld hl,$C000 / inc (hl) / ld a,(hl) / ldh ($43),a / jr -6
+	gb::gb_hardware hw{make_rom({0x21, 0x00, 0xC0, 0x34, 0x7E, 0xE0, 0x43, 0x18, 0xFA})};
+	run_frames(hw, 3);
+
+	std::vector<uint8_t> state;
+	hw.save_state(state);
+	const auto elapsed = hw.elapsed;
+
+	gb::hash_log logs[2];
+	for (auto &log : logs)
+	{
+		hw.load_state(state);
+		BOOST_CHECK(hw.elapsed == elapsed);
+		hw.log_hashes(&log);
+		run_frames(hw, 5);
+		hw.log_hashes(nullptr);
+	}
+	BOOST_CHECK_EQUAL(logs[0].hashes().size(), 5u);
+	BOOST_CHECK(logs[0].hashes() == logs[1].hashes());
+	BOOST_CHECK(logs[0].hashes()[3] != logs[0].hashes()[4]);
+
+	// loading and saving gives the same state
+	std::vector<uint8_t> again;
+	hw.load_state(state);
+	hw.save_state(again);
+	BOOST_CHECK(state == again);
+}
+
+BOOST_AUTO_TEST_CASE(test_save_state_run_ahead)
+{
+	// Draws a line into the tiles in black and white with the LCD off, then counts in WRAM at
+	// C000 and copies the count to the scroll, so every frame looks different:
+	// xor a / ldh ($40),a / ld a,$0F / ld ($8000),a / ld a,$80 / ldh ($68),a / xor a / ldh ($69),a /
+	// ldh ($69),a / ld a,$91 / ldh ($40),a / ld hl,$C000 / inc (hl) / ld a,(hl) / ldh ($43),a / jr -6
+	const auto rom = make_rom({0xAF, 0xE0, 0x40, 0x3E, 0x0F, 0xEA, 0x00, 0x80, 0x3E, 0x80, 0xE0, 0x68,
+		0xAF, 0xE0, 0x69, 0xE0, 0x69, 0x3E, 0x91, 0xE0, 0x40, 0x21, 0x00, 0xC0, 0x34, 0x7E, 0xE0, 0x43,
+		0x18, 0xFA});
+	const int ahead = 2;
+	const int frames = 6;
+
+	struct run
+	{
+		gb::gb_hardware hw;
+		gb::hash_log log;
+		std::vector<std::vector<uint8_t>> shown;  // every frame complete
+		std::vector<gb::audio_frame> samples;
+
+		run(const gb::rom &rom, int run_ahead, bool pipelined) : hw(rom)
+		{
+			hw.video.set_pipelined(pipelined);
+			hw.video.on_frame_complete([this](const gb::framebuffer &frame) { shown.push_back(frame_bytes(frame)); });
+			hw.set_run_ahead(run_ahead);
+			hw.log_hashes(&log);
+		}
+
+		void run_frames(int count)
+		{
+			std::vector<gb::audio_frame> buffer(gb::sound::sample_buffer::capacity());
+			for (int i = 0; i < count; ++i)
+			{
+				::run_frames(hw, 1);
+				const auto n = hw.sound.samples().pop(buffer.data(), buffer.size());
+				samples.insert(samples.end(), buffer.begin(), buffer.begin() + n);
+			}
+			hw.video.sync();
+		}
+	};
+
+	for (bool pipelined : {false, true})
+	{
+		run normal(rom, 0, pipelined), ahead_of(rom, ahead, pipelined);
+		normal.run_frames(frames + ahead);
+		ahead_of.run_frames(frames);
+
+		// The emulation itself is the same as without run ahead
+		std::vector<uint8_t> state, expected;
+		ahead_of.hw.save_state(state);
+		gb::gb_hardware reference{rom};
+		run_frames(reference, frames);
+		reference.save_state(expected);
+		BOOST_CHECK(state == expected);
+		BOOST_CHECK(ahead_of.log.hashes() == std::vector<uint64_t>(normal.log.hashes().begin(), normal.log.hashes().begin() + frames));
+		// no samples of the frames ahead, a prefix of the samples of the longer run
+		BOOST_CHECK(ahead_of.samples.size() > 0 && ahead_of.samples.size() < normal.samples.size());
+		BOOST_CHECK(std::equal(ahead_of.samples.begin(), ahead_of.samples.end(), normal.samples.begin(),
+			[](const gb::audio_frame &a, const gb::audio_frame &b) { return a.left == b.left && a.right == b.right; }));
+
+		// Once per frame, showing the frame ahead
+		BOOST_REQUIRE_EQUAL(ahead_of.shown.size(), frames);
+		BOOST_REQUIRE_EQUAL(normal.shown.size(), frames + ahead);
+		for (int i = 0; i < frames; ++i)
+			BOOST_CHECK(ahead_of.shown[i] == normal.shown[i + ahead]);
+		BOOST_CHECK(normal.shown[frames] != normal.shown[frames + 1]);
+
+		// The emulation itself isn't drawn, the frame ahead stays until the next one
+		auto &hw = ahead_of.hw;
+		uint8_t ly = hw.cpu->memory().read8(gb::video::r::ly);
+		for (;;)
+		{
+			const auto frame = hw.video.frames();
+			hw.tick();
+			if (hw.video.frames() != frame)
+				break;
+			if (hw.cpu->memory().read8(gb::video::r::ly) == ly)
+				continue;
+			ly = hw.cpu->memory().read8(gb::video::r::ly);
+			hw.video.sync();
+			BOOST_REQUIRE(frame_bytes(hw.video.frame()) == ahead_of.shown.back());
+		}
+		hw.video.sync();
+		BOOST_CHECK_EQUAL(ahead_of.shown.size(), frames + 1);
+	}
+}
@@ -0,0 +1,75 @@
+#include "sound.hpp"
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <vector>
+
+using namespace std::chrono;
+using gb::cputime;
+
+BOOST_AUTO_TEST_CASE(test_sound_sample_rate)
+{
+	gb::sound sound;
+	std::vector<gb::audio_frame> frames(gb::sound::sample_buffer::capacity());
+
+	size_t count = 0;
+	for (int i = 0; i < 64; ++i)
+	{
+		sound.tick(duration_cast<cputime>(seconds(1)) / 64);
+		sound.flush();
+		count += sound.samples().pop(frames.data(), frames.size());
+	}
+	BOOST_CHECK_EQUAL(count, gb::sound::sample_rate);
+}
+
+BOOST_AUTO_TEST_CASE(test_sound_length_counter)
+{
+	gb::sound sound;
+	sound.write8(gb::sound::r::nr22, 0xF0);  // DAC on, full volume
+	sound.write8(gb::sound::r::nr21, 0x3E);  // length 2
+	sound.write8(gb::sound::r::nr24, 0xC0);  // trigger with length enabled
+
+	uint8_t nr52;
+	sound.read8(gb::sound::r::nr52, nr52);
+	BOOST_CHECK_EQUAL(nr52 & 0x02, 0x02);
+
+	// the length is clocked with 256 Hz
+	sound.tick(duration_cast<cputime>(milliseconds(4)));
+	sound.read8(gb::sound::r::nr52, nr52);
+	BOOST_CHECK_EQUAL(nr52 & 0x02, 0x02);
+	sound.tick(duration_cast<cputime>(milliseconds(8)));
+	sound.read8(gb::sound::r::nr52, nr52);
+	BOOST_CHECK_EQUAL(nr52 & 0x02, 0x00);
+
+	// powered off all writes are ignored
+	sound.write8(gb::sound::r::nr52, 0x00);
+	sound.write8(gb::sound::r::nr50, 0x77);
+	uint8_t nr50;
+	sound.read8(gb::sound::r::nr50, nr50);
+	BOOST_CHECK_EQUAL(nr50, 0x00);
+	sound.read8(gb::sound::r::nr52, nr52);
+	BOOST_CHECK_EQUAL(nr52, 0x70);
+}
+
+BOOST_AUTO_TEST_CASE(test_sound_sweep_overflow_status)
+{
+	gb::sound sound;
+	sound.write8(gb::sound::r::nr12, 0xF0);  // DAC on, full volume
+	sound.write8(gb::sound::r::nr10, 0x11);  // period 1, shift 1, increasing
+	sound.write8(gb::sound::r::nr13, 0x00);
+	sound.write8(gb::sound::r::nr14, 0x84);  // trigger at frequency 0x400
+
+	// the first sweep step (frame sequencer step 2) overflows, seen without a flush
+	const cputime overflow(3 * 16384);
+	const cputime step(1000);
+	cputime time(0);
+	uint8_t nr52;
+	for (; time + step <= overflow; time += step)
+	{
+		sound.tick(step);
+		sound.read8(gb::sound::r::nr52, nr52);
+		BOOST_REQUIRE_EQUAL(nr52 & 0x01, 0x01);
+	}
+	sound.tick(step);
+	sound.read8(gb::sound::r::nr52, nr52);
+	BOOST_CHECK_EQUAL(nr52 & 0x01, 0x00);
+}
@@ -0,0 +1,111 @@
+#include "state_hash.hpp"
+#include "gb_thread.hpp"
+#include "internal_ram.hpp"
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <sstream>
+
+using gb::cputime;
+
+BOOST_AUTO_TEST_CASE(test_state_hash_xxh64)
+{
+	const char *text = "Nobody inspects the spammish repetition";
+	BOOST_CHECK_EQUAL(gb::hash64("", 0), 0xEF46DB3751D8E999ULL);
+	BOOST_CHECK_EQUAL(gb::hash64("abc", 3), 0x44BC2CF5AD770999ULL);
+	BOOST_CHECK_EQUAL(gb::hash64(text, std::strlen(text)), 0xFBCEA83C8A378BF1ULL);
+}
+
+BOOST_AUTO_TEST_CASE(test_state_hash_log)
+{
+	gb::hash_log a, b;
+	for (uint64_t i = 0; i < 1000; ++i)
+	{
+		a.add(i);
+		b.add(i < 613 ? i : i + 1);
+	}
+	BOOST_CHECK_EQUAL(gb::hash_log::first_difference(a, b), 613);
+	BOOST_CHECK_EQUAL(gb::hash_log::first_difference(a, a), 1000);
+
+	std::stringstream file;
+	b.write(file);
+	gb::hash_log read;
+	read.read(file);
+	BOOST_CHECK(read.hashes() == b.hashes());
+}
+
+BOOST_AUTO_TEST_CASE(test_state_hash_runs)
+{
+	// Counts in WRAM at C000: ld hl,$C000 / inc (hl) / jr -3
+	std::vector<uint8_t> data(0x8000, 0x00);
+	const uint8_t program[] = {0x21, 0x00, 0xC0, 0x34, 0x18, 0xFD};
+	std::copy(std::begin(program), std::end(program), data.begin() + 0x100);
+	const gb::rom rom(data);
+
+	gb::hash_log logs[2];
+	for (auto &log : logs)
+	{
+		gb::gb_hardware hw(rom);
+		hw.log_hashes(&log);
+		while (log.hashes().size() < 10)
+			hw.tick();
+	}
+	BOOST_CHECK(logs[0].hashes() == logs[1].hashes());
+	BOOST_CHECK(logs[0].hashes()[8] != logs[0].hashes()[9]);
+}
+
+BOOST_AUTO_TEST_CASE(test_state_hash_dirty_pages)
+{
+	gb::internal_ram a, b;
+	a.state_hash(0);
+	const auto seen = a.dirty().checkpoint();
+	BOOST_CHECK(!a.dirty().any(seen));
+	BOOST_CHECK(a.dirty().any(0));  // all pages are dirty at the start
+
+	a.write8(0xC234, 0x12);
+	a.write8(0xF000, 0x34);  // echo of D000, bank 1
+	a.write8(0xFF90, 0x56);  // high RAM isn't paged
+	std::vector<size_t> pages;
+	a.dirty().for_each(seen, [&](size_t page) { pages.push_back(page); });
+	BOOST_REQUIRE_EQUAL(pages.size(), 2);
+	BOOST_CHECK_EQUAL(pages[0], 0x02);
+	BOOST_CHECK_EQUAL(pages[1], 0x10);
+
+	// Rehashing the dirty pages gives the same as hashing everything
+	b.write8(0xC234, 0x12);
+	b.write8(0xD000, 0x34);
+	b.write8(0xFF90, 0x56);
+	BOOST_CHECK_EQUAL(a.state_hash(0), b.state_hash(0));
+	BOOST_CHECK(a.dirty().any(seen));  // not cleared for other consumers
+
+	gb::dirty_pages dirty(0x4000);
+	const auto checkpoint = dirty.checkpoint();
+	dirty.mark(0x1F0, 0x20);
+	BOOST_CHECK(dirty.test(1, checkpoint) && dirty.test(2, checkpoint) && !dirty.test(0, checkpoint) && !dirty.test(3, checkpoint));
+}
+
+BOOST_AUTO_TEST_CASE(test_state_hash_dirty_pages_consumers)
+{
+	// Two consumers of the same pages which update at different times both see every write
+	std::vector<uint8_t> data(0x1000);
+	gb::dirty_pages dirty(data.size());
+	gb::page_hashes first(data.size()), second(data.size());
+	first.update(data.data(), dirty, 0);
+	second.update(data.data(), dirty, 0);
+
+	const auto write = [&](size_t offset, uint8_t value) {
+		data[offset] = value;
+		dirty.mark(offset);
+	};
+	const auto full_hash = [&] {
+		gb::dirty_pages all(data.size());
+		return gb::page_hashes(data.size()).update(data.data(), all, 0);
+	};
+
+	write(0x123, 1);
+	BOOST_CHECK_EQUAL(first.update(data.data(), dirty, 0), full_hash());
+	write(0x345, 2);
+	BOOST_CHECK_EQUAL(second.update(data.data(), dirty, 0), full_hash());
+	write(0xF00, 3);
+	BOOST_CHECK_EQUAL(first.update(data.data(), dirty, 0), full_hash());
+	BOOST_CHECK_EQUAL(second.update(data.data(), dirty, 0), full_hash());
+}
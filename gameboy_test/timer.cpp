@@ -99,3 +99,25 @@ BOOST_AUTO_TEST_CASE(test_timer_tima_tma_tac)
 	timer.tick(cpu, cputime(512));
 	BOOST_CHECK_EQUAL(cpu.memory().read8(gb::timer::tima), 0x44);
 }
+
+BOOST_AUTO_TEST_CASE(test_timer_time_until_event)
+{
+	gb::timer timer;
+	gb::internal_ram internal_ram;
+	gb::memory_map memory;
+	memory.add_mapping(&timer);
+	memory.add_mapping(&internal_ram);
+	gb::z80_cpu cpu(std::move(memory), gb::register_file());
+
+	BOOST_CHECK(timer.time_until_event(cpu) == cputime::max());
+
+	cpu.memory().write8(gb::timer::tac, 0x05);
+	cpu.memory().write8(gb::timer::tima, 0xfe);
+	BOOST_CHECK_EQUAL(timer.time_until_event(cpu).count(), 64);
+	timer.tick(cpu, cputime(40));
+	BOOST_CHECK_EQUAL(timer.time_until_event(cpu).count(), 24);
+	timer.tick(cpu, cputime(23));
+	BOOST_CHECK_EQUAL(cpu.memory().read8(gb::internal_ram::if_) & 0x4, 0);
+	timer.tick(cpu, cputime(1));
+	BOOST_CHECK_EQUAL(cpu.memory().read8(gb::internal_ram::if_) & 0x4, 0x4);
+}
@@ -0,0 +1,657 @@
+#include "video.hpp"
+#include "z80.hpp"
+#include "internal_ram.hpp"
+#include "save_state.hpp"
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cstring>
+
+using gb::cputime;
+
+BOOST_AUTO_TEST_CASE(test_video_general_purpose_dma)
+{
+	gb::video video;
+	gb::internal_ram internal_ram;
+	gb::memory_map memory;
+	memory.add_mapping(&video);
+	memory.add_mapping(&internal_ram);
+	gb::z80_cpu cpu(std::move(memory), gb::register_file());
+
+	for (uint16_t i = 0; i < 0x40; ++i)
+		cpu.memory().write8(0xC0F0 + i, static_cast<uint8_t>(i + 1));
+
+	// 0x30 bytes from C0F0 (crossing a page) to 8810
+	cpu.memory().write8(gb::video::r::hdma1, 0xC0);
+	cpu.memory().write8(gb::video::r::hdma2, 0xF0);
+	cpu.memory().write8(gb::video::r::hdma3, 0x08);
+	cpu.memory().write8(gb::video::r::hdma4, 0x10);
+	cpu.memory().write8(gb::video::r::hdma5, 0x02);
+	BOOST_CHECK_EQUAL(video.time_until_event(cpu).count(), 0);
+	video.tick(cpu, cputime(1));
+
+	for (uint16_t i = 0; i < 0x30; ++i)
+		BOOST_CHECK_EQUAL(cpu.memory().read8(0x8810 + i), i + 1);
+	BOOST_CHECK_EQUAL(cpu.memory().read8(0x8840), 0);
+	BOOST_CHECK_EQUAL(cpu.memory().read8(gb::video::r::hdma5), 0xFF);
+	BOOST_CHECK(video.take_cpu_stall() == 3 * gb::video::hdma_block_time);
+	BOOST_CHECK(video.take_cpu_stall() == cputime(0));
+}
+
+BOOST_AUTO_TEST_CASE(test_video_hblank_dma)
+{
+	gb::video video;
+	gb::internal_ram internal_ram;
+	gb::memory_map memory;
+	memory.add_mapping(&video);
+	memory.add_mapping(&internal_ram);
+	gb::z80_cpu cpu(std::move(memory), gb::register_file());
+
+	for (uint16_t i = 0; i < 0x20; ++i)
+		cpu.memory().write8(0xC000 + i, static_cast<uint8_t>(i + 1));
+
+	cpu.memory().write8(gb::video::r::hdma1, 0xC0);
+	cpu.memory().write8(gb::video::r::hdma2, 0x00);
+	cpu.memory().write8(gb::video::r::hdma3, 0x00);
+	cpu.memory().write8(gb::video::r::hdma4, 0x00);
+	cpu.memory().write8(gb::video::r::hdma5, 0x81);
+	cpu.memory().write8(gb::video::r::lcdc, gb::video::lcdc_flag::lcd_enable | gb::video::lcdc_flag::bg_display);
+
+	// one block per hblank
+	for (int hblank = 1; hblank <= 2; ++hblank)
+	{
+		do
+		{
+			video.tick(cpu, video.time_until_event(cpu));
+		} while ((cpu.memory().read8(gb::video::r::stat) & gb::video::stat_flag::mode) != gb::video::mode::hblank);
+
+		BOOST_CHECK(video.take_cpu_stall() == gb::video::hdma_block_time);
+		BOOST_CHECK_EQUAL(cpu.memory().read8(0x8000 + hblank * 0x10 - 1), hblank * 0x10);
+		BOOST_CHECK_EQUAL(cpu.memory().read8(0x8000 + hblank * 0x10), 0);
+	}
+	BOOST_CHECK_EQUAL(cpu.memory().read8(gb::video::r::hdma5), 0xFF);
+}
+
+BOOST_AUTO_TEST_CASE(test_video_oam_dma)
+{
+	gb::video video;
+	gb::internal_ram internal_ram;
+	gb::memory_map memory;
+	memory.add_mapping(&video);
+	memory.add_mapping(&internal_ram);
+	gb::z80_cpu cpu(std::move(memory), gb::register_file());
+
+	for (uint16_t i = 0; i < 0xA0; ++i)
+		cpu.memory().write8(0xC100 + i, static_cast<uint8_t>(0xA0 - i));
+
+	cpu.memory().write8(gb::video::r::dma, 0xC1);
+	video.tick(cpu, cputime(1));
+	video.tick(cpu, gb::video::dma_time);
+
+	for (uint16_t i = 0; i < 0xA0; ++i)
+		BOOST_CHECK_EQUAL(cpu.memory().read8(0xFE00 + i), 0xA0 - i);
+}
+
+namespace
+{
+
+void write_palette(gb::z80_cpu &cpu, uint16_t index_reg, const uint16_t (&colors)[4])
+{
+	cpu.memory().write8(index_reg, 0x80);  // palette 0, auto increment
+	for (auto color : colors)
+	{
+		cpu.memory().write8(index_reg + 1, static_cast<uint8_t>(color));
+		cpu.memory().write8(index_reg + 1, static_cast<uint8_t>(color >> 8));
+	}
+}
+
+void run_frame(gb::video &video, gb::z80_cpu &cpu)
+{
+	const auto frame = video.frames();
+	while (video.frames() == frame)
+		video.tick(cpu, std::max(video.time_until_event(cpu), cputime(1)));
+}
+
+using rgb = std::array<uint8_t, 3>;
+const rgb white{{255, 255, 255}}, red{{255, 0, 0}}, green{{0, 255, 0}}, blue{{0, 0, 255}};
+const rgb magenta{{255, 0, 255}}, yellow{{255, 255, 0}}, cyan{{0, 255, 255}};
+
+// RGB of a pixel of a frame in pixel_format::rgb888
+rgb pixel(const gb::video &video, int x, int y)
+{
+	const auto *p = video.frame().line(y) + x * 3;
+	return rgb{{p[0], p[1], p[2]}};
+}
+
+// Color indices of the test tile, every row is the same
+const int tile_colors[8] = {3, 3, 1, 1, 2, 2, 0, 0};
+
+}
+
+BOOST_AUTO_TEST_CASE(test_video_render_bg_and_sprites)
+{
+	gb::video video;
+	gb::internal_ram internal_ram;
+	gb::memory_map memory;
+	memory.add_mapping(&video);
+	memory.add_mapping(&internal_ram);
+	gb::z80_cpu cpu(std::move(memory), gb::register_file());
+
+	cpu.memory().write8(gb::video::r::lcdc, 0);
+	write_palette(cpu, gb::video::r::bgpi, {0x7FFF, 0x001F, 0x03E0, 0x7C00});
+	write_palette(cpu, gb::video::r::obpi, {0x0000, 0x7C1F, 0x03FF, 0x7FE0});
+	for (uint16_t row = 0; row < 8; ++row)
+	{
+		cpu.memory().write8(0x8010 + row * 2, 0xF0);
+		cpu.memory().write8(0x8011 + row * 2, 0xCC);
+	}
+	for (uint16_t i = 0; i < 0x400; ++i)
+		cpu.memory().write8(0x9800 + i, 1);
+	// sprite 0 with tile 1 at (20, 30)
+	cpu.memory().write8(0xFE00, 16 + 30);
+	cpu.memory().write8(0xFE01, 8 + 20);
+	cpu.memory().write8(0xFE02, 1);
+	cpu.memory().write8(0xFE03, 0);
+
+	using f = gb::video::lcdc_flag;
+	cpu.memory().write8(gb::video::r::lcdc, f::lcd_enable | f::bg_window_data_select | f::obj_display_enable | f::bg_display);
+	run_frame(video, cpu);
+	run_frame(video, cpu);
+
+	const rgb bg[] = {white, red, green, blue};
+	const rgb obj[] = {white, magenta, yellow, cyan};
+	for (int y : {0, 29, 30, 37, 38, 143})
+	{
+		for (int x = 0; x < gb::video::width; ++x)
+		{
+			auto expected = bg[tile_colors[x % 8]];
+			if (30 <= y && y < 38 && 20 <= x && x < 28 && tile_colors[x - 20] != 0)
+				expected = obj[tile_colors[x - 20]];
+			BOOST_CHECK(pixel(video, x, y) == expected);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_video_sprite_lines)
+{
+	gb::video video;
+	gb::internal_ram internal_ram;
+	gb::memory_map memory;
+	memory.add_mapping(&video);
+	memory.add_mapping(&internal_ram);
+	gb::z80_cpu cpu(std::move(memory), gb::register_file());
+
+	cpu.memory().write8(gb::video::r::lcdc, 0);
+	write_palette(cpu, gb::video::r::bgpi, {0x7FFF, 0x7FFF, 0x7FFF, 0x7FFF});
+	write_palette(cpu, gb::video::r::obpi, {0x0000, 0x7C1F, 0x03FF, 0x7FE0});
+	for (uint16_t i = 0; i < 0x20; ++i)
+		cpu.memory().write8(0x8040 + i, 0xFF);  // tiles 4 and 5 with color 3
+	// 11 sprites on the same line, the last one isn't drawn
+	for (uint16_t i = 0; i < 11; ++i)
+	{
+		cpu.memory().write8(0xFE00 + i * 4, 16 + 10);
+		cpu.memory().write8(0xFE01 + i * 4, 8 + i * 8);
+		cpu.memory().write8(0xFE02 + i * 4, 4);
+	}
+
+	using f = gb::video::lcdc_flag;
+	const uint8_t lcdc = f::lcd_enable | f::bg_window_data_select | f::obj_display_enable | f::bg_display;
+	cpu.memory().write8(gb::video::r::lcdc, lcdc);
+	run_frame(video, cpu);
+	run_frame(video, cpu);
+	BOOST_CHECK(pixel(video, 0, 17) == cyan);
+	BOOST_CHECK(pixel(video, 79, 17) == cyan);
+	BOOST_CHECK(pixel(video, 80, 17) == white);
+	BOOST_CHECK(pixel(video, 0, 18) == white);
+
+	// 8x16 sprites cover 8 more lines
+	cpu.memory().write8(gb::video::r::lcdc, lcdc | f::obj_size);
+	run_frame(video, cpu);
+	BOOST_CHECK(pixel(video, 0, 25) == cyan);
+	BOOST_CHECK(pixel(video, 0, 26) == white);
+
+	// moved by an OAM write
+	cpu.memory().write8(gb::video::r::lcdc, 0);
+	cpu.memory().write8(0xFE00, 16 + 100);
+	cpu.memory().write8(gb::video::r::lcdc, lcdc);
+	run_frame(video, cpu);
+	BOOST_CHECK(pixel(video, 0, 10) == white);
+	BOOST_CHECK(pixel(video, 0, 100) == cyan);
+}
+
+BOOST_AUTO_TEST_CASE(test_video_pixel_formats)
+{
+	gb::video video;
+	gb::internal_ram internal_ram;
+	gb::memory_map memory;
+	memory.add_mapping(&video);
+	memory.add_mapping(&internal_ram);
+	gb::z80_cpu cpu(std::move(memory), gb::register_file());
+
+	cpu.memory().write8(gb::video::r::lcdc, 0);
+	write_palette(cpu, gb::video::r::bgpi, {0x7FFF, 0x001F, 0x03E0, 0x7C00});
+	for (uint16_t row = 0; row < 8; ++row)
+	{
+		cpu.memory().write8(0x8010 + row * 2, 0xF0);
+		cpu.memory().write8(0x8011 + row * 2, 0xCC);
+	}
+	for (uint16_t i = 0; i < 0x400; ++i)
+		cpu.memory().write8(0x9800 + i, 1);
+	using f = gb::video::lcdc_flag;
+	cpu.memory().write8(gb::video::r::lcdc, f::lcd_enable | f::bg_window_data_select | f::bg_display);
+
+	// a line is blue blue red red green green white white, repeated
+	video.set_pixel_format(gb::pixel_format::rgba8888);
+	BOOST_CHECK_EQUAL(video.frame().stride, 4u * gb::video::width);
+	run_frame(video, cpu);
+	const uint8_t rgba[] = {255, 0, 0, 255, 255, 0, 0, 255, 0, 255, 0, 255, 0, 255, 0, 255};
+	BOOST_CHECK(std::equal(std::begin(rgba), std::end(rgba), video.frame().line(143) + 4 * 2));
+
+	video.set_pixel_format(gb::pixel_format::rgb565, 1024);
+	BOOST_CHECK_EQUAL(video.frame().stride, 1024u);
+	run_frame(video, cpu);
+	uint16_t rgb565[4];
+	std::memcpy(rgb565, video.frame().line(10), sizeof(rgb565));
+	BOOST_CHECK_EQUAL(rgb565[0], 0x001F);
+	BOOST_CHECK_EQUAL(rgb565[2], 0xF800);
+	BOOST_CHECK_EQUAL(rgb565[3], 0xF800);
+
+	// background palette 0, color 3, 1 and 2
+	video.set_pixel_format(gb::pixel_format::indexed);
+	run_frame(video, cpu);
+	const auto *line = video.frame().line(0);
+	BOOST_CHECK_EQUAL(line[0], 3);
+	BOOST_CHECK_EQUAL(line[2], 1);
+	BOOST_CHECK_EQUAL(line[4], 2);
+	BOOST_CHECK_EQUAL(line[6], 0);
+	BOOST_CHECK(video.palette()[1] == red);
+	BOOST_CHECK(video.palette()[3] == blue);
+}
+
+BOOST_AUTO_TEST_CASE(test_video_external_framebuffer)
+{
+	gb::video video;
+	gb::internal_ram internal_ram;
+	gb::memory_map memory;
+	memory.add_mapping(&video);
+	memory.add_mapping(&internal_ram);
+	gb::z80_cpu cpu(std::move(memory), gb::register_file());
+
+	cpu.memory().write8(gb::video::r::lcdc, 0);
+	write_palette(cpu, gb::video::r::bgpi, {0x001F, 0x001F, 0x001F, 0x001F});
+	using f = gb::video::lcdc_flag;
+	cpu.memory().write8(gb::video::r::lcdc, f::lcd_enable | f::bg_window_data_select | f::bg_display);
+
+	// 8 bytes of padding after every line stay untouched
+	const size_t stride = gb::video::width * 4 + 8;
+	std::vector<uint8_t> buffer(stride * gb::video::height, 0xAA);
+	video.attach_framebuffer({buffer.data(), stride, gb::pixel_format::rgba8888});
+	int frames = 0;
+	video.on_frame_complete([&](const gb::framebuffer &frame) {
+		BOOST_CHECK(frame.data == buffer.data());
+		++frames;
+	});
+	run_frame(video, cpu);
+	run_frame(video, cpu);
+	BOOST_CHECK_EQUAL(frames, 2);
+
+	const uint8_t red[] = {255, 0, 0, 255};
+	for (int y : {0, 143})
+	{
+		const auto *line = &buffer[y * stride];
+		BOOST_CHECK(std::equal(std::begin(red), std::end(red), line));
+		BOOST_CHECK(std::equal(std::begin(red), std::end(red), line + 4 * (gb::video::width - 1)));
+		BOOST_CHECK_EQUAL(line[4 * gb::video::width], 0xAA);
+	}
+
+	// detached again
+	video.attach_framebuffer({nullptr, 0, gb::pixel_format::indexed});
+	BOOST_CHECK(video.frame().data != buffer.data());
+	BOOST_CHECK_EQUAL(video.frame().stride, static_cast<size_t>(gb::video::width));
+}
+
+BOOST_AUTO_TEST_CASE(test_video_gray_view)
+{
+	gb::video video;
+	gb::internal_ram internal_ram;
+	gb::memory_map memory;
+	memory.add_mapping(&video);
+	memory.add_mapping(&internal_ram);
+	gb::z80_cpu cpu(std::move(memory), gb::register_file());
+
+	cpu.memory().write8(gb::video::r::lcdc, 0);
+	write_palette(cpu, gb::video::r::bgpi, {0x7FFF, 0x001F, 0x03E0, 0x7C00});
+	for (uint16_t row = 0; row < 8; ++row)
+	{
+		cpu.memory().write8(0x8010 + row * 2, 0xF0);
+		cpu.memory().write8(0x8011 + row * 2, 0xCC);
+	}
+	for (uint16_t i = 0; i < 0x400; ++i)
+		cpu.memory().write8(0x9800 + i, 1);
+	using f = gb::video::lcdc_flag;
+	cpu.memory().write8(gb::video::r::lcdc, f::lcd_enable | f::bg_window_data_select | f::bg_display);
+
+	// a line is blue blue red red green green white white, repeated
+	video.set_view({1, 8, 158, 128, 2});
+	video.set_pixel_format(gb::pixel_format::gray8);
+	BOOST_CHECK_EQUAL(video.frame().stride, 79u);
+	run_frame(video, cpu);
+	for (int y : {0, 63})
+	{
+		const auto *line = video.frame().line(y);
+		BOOST_CHECK_EQUAL(line[0], (28 + 28 + 76 + 76) / 4);
+		BOOST_CHECK_EQUAL(line[1], (76 + 76 + 149 + 149) / 4);
+		BOOST_CHECK_EQUAL(line[2], (149 + 149 + 255 + 255) / 4);
+		BOOST_CHECK_EQUAL(line[3], (255 + 255 + 28 + 28) / 4);
+	}
+
+	// the other formats take the top left pixel of a block
+	video.set_pixel_format(gb::pixel_format::rgb888);
+	run_frame(video, cpu);
+	BOOST_CHECK(pixel(video, 0, 0) == blue);
+	BOOST_CHECK(pixel(video, 1, 0) == red);
+	BOOST_CHECK(pixel(video, 2, 63) == green);
+	BOOST_CHECK(pixel(video, 3, 63) == white);
+}
+
+BOOST_AUTO_TEST_CASE(test_video_window)
+{
+	gb::video video;
+	gb::internal_ram internal_ram;
+	gb::memory_map memory;
+	memory.add_mapping(&video);
+	memory.add_mapping(&internal_ram);
+	gb::z80_cpu cpu(std::move(memory), gb::register_file());
+
+	cpu.memory().write8(gb::video::r::lcdc, 0);
+	write_palette(cpu, gb::video::r::bgpi, {0x7FFF, 0x001F, 0x03E0, 0x7C00});
+	for (uint16_t row = 0; row < 8; ++row)
+	{
+		cpu.memory().write8(0x8010 + row * 2, 0xF0);  // tile 1 like tile_colors
+		cpu.memory().write8(0x8011 + row * 2, 0xCC);
+		cpu.memory().write8(0x8020 + row * 2, 0xFF);  // tile 2 blue
+		cpu.memory().write8(0x8021 + row * 2, 0xFF);
+		cpu.memory().write8(0x8030 + row * 2, 0xFF);  // tile 3 red
+	}
+	for (uint16_t i = 0; i < 0x400; ++i)
+	{
+		cpu.memory().write8(0x9800 + i, 1);
+		cpu.memory().write8(0x9C00 + i, i < 32 ? 2 : 3);
+	}
+	cpu.memory().write8(gb::video::r::wy, 50);
+	cpu.memory().write8(gb::video::r::wx, 7 + 80);
+	cpu.memory().write8(gb::video::r::scx, 3);
+
+	using f = gb::video::lcdc_flag;
+	cpu.memory().write8(gb::video::r::lcdc, f::lcd_enable | f::window_tile_map_display_select
+		| f::window_display_enable | f::bg_window_data_select | f::bg_display);
+	run_frame(video, cpu);
+	run_frame(video, cpu);
+
+	// the window starts with its first line at WY, no matter the screen line
+	const rgb bg[] = {white, red, green, blue};
+	for (int y : {0, 49, 50, 57, 58, 143})
+	{
+		for (int x = 0; x < gb::video::width; ++x)
+		{
+			auto expected = bg[tile_colors[(x + 3) % 8]];
+			if (y >= 50 && x >= 80)
+				expected = y < 58 ? blue : red;
+			BOOST_CHECK(pixel(video, x, y) == expected);
+		}
+	}
+
+	// a window left of the screen is shifted out
+	cpu.memory().write8(gb::video::r::wx, 0);
+	cpu.memory().write8(gb::video::r::wy, 0);
+	run_frame(video, cpu);
+	BOOST_CHECK(pixel(video, 0, 7) == blue);
+	BOOST_CHECK(pixel(video, 159, 8) == red);
+}
+
+BOOST_AUTO_TEST_CASE(test_video_flips)
+{
+	gb::video video;
+	gb::internal_ram internal_ram;
+	gb::memory_map memory;
+	memory.add_mapping(&video);
+	memory.add_mapping(&internal_ram);
+	gb::z80_cpu cpu(std::move(memory), gb::register_file());
+
+	cpu.memory().write8(gb::video::r::lcdc, 0);
+	write_palette(cpu, gb::video::r::bgpi, {0x7FFF, 0x7FFF, 0x7FFF, 0x7C00});
+	write_palette(cpu, gb::video::r::obpi, {0x0000, 0x0000, 0x0000, 0x7FE0});
+	// tiles 1 and 2 only have their top left pixel set
+	for (uint16_t addr : {0x8010, 0x8011, 0x8020, 0x8021})
+		cpu.memory().write8(addr, 0x80);
+	for (uint16_t i = 0; i < 3; ++i)
+		cpu.memory().write8(0x9800 + i, 1);
+	// attributes: x flip, y flip, both
+	cpu.memory().write8(gb::video::r::vbk, 1);
+	cpu.memory().write8(0x9800, 0x20);
+	cpu.memory().write8(0x9801, 0x40);
+	cpu.memory().write8(0x9802, 0x60);
+	cpu.memory().write8(gb::video::r::vbk, 0);
+
+	// 8x16 sprite of tiles 2 and 3 flipped both ways at (40, 40)
+	cpu.memory().write8(0xFE00, 16 + 40);
+	cpu.memory().write8(0xFE01, 8 + 40);
+	cpu.memory().write8(0xFE02, 2);
+	cpu.memory().write8(0xFE03, 0x60);
+
+	using f = gb::video::lcdc_flag;
+	cpu.memory().write8(gb::video::r::lcdc, f::lcd_enable | f::bg_window_data_select
+		| f::obj_size | f::obj_display_enable | f::bg_display);
+	run_frame(video, cpu);
+	run_frame(video, cpu);
+
+	BOOST_CHECK(pixel(video, 0, 0) == white);
+	BOOST_CHECK(pixel(video, 7, 0) == blue);
+	BOOST_CHECK(pixel(video, 8, 0) == white);
+	BOOST_CHECK(pixel(video, 8, 7) == blue);
+	BOOST_CHECK(pixel(video, 23, 7) == blue);
+	BOOST_CHECK(pixel(video, 16, 0) == white);
+
+	BOOST_CHECK(pixel(video, 40, 40) == white);
+	BOOST_CHECK(pixel(video, 47, 55) == cyan);
+	BOOST_CHECK(pixel(video, 40, 55) == white);
+}
+
+BOOST_AUTO_TEST_CASE(test_video_pipelined)
+{
+	// the same writes to two videos, one of them draws on another thread
+	struct system
+	{
+		gb::video video;
+		gb::internal_ram internal_ram;
+		gb::z80_cpu cpu;
+
+		system() : cpu(gb::memory_map(), gb::register_file())
+		{
+			cpu.memory().add_mapping(&video);
+			cpu.memory().add_mapping(&internal_ram);
+		}
+	};
+	system direct, pipelined;
+	pipelined.video.set_pipelined(true);
+	int frames = 0;
+	pipelined.video.on_frame_complete([&](const gb::framebuffer &) { ++frames; });
+
+	using f = gb::video::lcdc_flag;
+	for (auto *s : {&direct, &pipelined})
+	{
+		auto &cpu = s->cpu;
+		cpu.memory().write8(gb::video::r::lcdc, 0);
+		write_palette(cpu, gb::video::r::bgpi, {0x7FFF, 0x001F, 0x03E0, 0x7C00});
+		write_palette(cpu, gb::video::r::obpi, {0x0000, 0x7C1F, 0x03FF, 0x7FE0});
+		for (uint16_t i = 0; i < 0x800; ++i)
+			cpu.memory().write8(0x8000 + i, static_cast<uint8_t>(i * 7));
+		for (uint16_t i = 0; i < 0x800; ++i)
+			cpu.memory().write8(0x9800 + i, static_cast<uint8_t>(i / 3));
+		for (uint16_t i = 0; i < 0xA0; ++i)
+			cpu.memory().write8(0xFE00 + i, static_cast<uint8_t>(i * 13));
+		cpu.memory().write8(gb::video::r::wy, 90);
+		cpu.memory().write8(gb::video::r::wx, 50);
+		cpu.memory().write8(gb::video::r::lcdc, f::lcd_enable | f::window_tile_map_display_select
+			| f::window_display_enable | f::bg_window_data_select | f::obj_display_enable | f::bg_display);
+	}
+
+	// scrolling, palette and tile changes on every line
+	const auto run_frames = [&](int count) {
+		for (auto *s : {&direct, &pipelined})
+		{
+			auto &cpu = s->cpu;
+			const auto end = s->video.frames() + count;
+			while (s->video.frames() < end)
+			{
+				const auto ly = cpu.memory().read8(gb::video::r::ly);
+				s->video.tick(cpu, std::max(s->video.time_until_event(cpu), cputime(1)));
+				const auto new_ly = cpu.memory().read8(gb::video::r::ly);
+				if (new_ly == ly)
+					continue;
+				cpu.memory().write8(gb::video::r::scx, static_cast<uint8_t>(new_ly * 3));
+				cpu.memory().write8(gb::video::r::bgpi, 2);
+				cpu.memory().write8(gb::video::r::bgpd, new_ly);
+				cpu.memory().write8(static_cast<uint16_t>(0x8000 + new_ly * 5), new_ly);
+			}
+		}
+	};
+	const auto frames_equal = [&]() {
+		pipelined.video.sync();
+		const auto size = gb::video::width * 3;
+		for (int y = 0; y < gb::video::height; ++y)
+			if (!std::equal(direct.video.frame().line(y), direct.video.frame().line(y) + size, pipelined.video.frame().line(y)))
+				return false;
+		return true;
+	};
+
+	run_frames(3);
+	BOOST_CHECK(frames_equal());
+	BOOST_CHECK(pixel(pipelined.video, 0, 0) != pixel(pipelined.video, 0, 1));
+	BOOST_CHECK_EQUAL(frames, 3);
+
+	pipelined.video.set_pipelined(false);
+	BOOST_CHECK(!pipelined.video.pipelined());
+	run_frames(1);
+	BOOST_CHECK(frames_equal());
+	BOOST_CHECK_EQUAL(frames, 4);
+}
+
+BOOST_AUTO_TEST_CASE(test_video_save_state_window)
+{
+	// saved in the middle of a frame which shows the window, the window line must be restored
+	struct system
+	{
+		gb::video video;
+		gb::internal_ram internal_ram;
+		gb::z80_cpu cpu;
+		std::vector<uint8_t> state;
+		std::vector<uint8_t> frame;  // lines from the save on
+
+		system() : cpu(gb::memory_map(), gb::register_file())
+		{
+			cpu.memory().add_mapping(&video);
+			cpu.memory().add_mapping(&internal_ram);
+		}
+	};
+	const int save_line = 100;
+	system direct, pipelined;
+	pipelined.video.set_pipelined(true);
+
+	const auto run_to_line = [](system &s, int line) {
+		while (s.cpu.memory().read8(gb::video::r::ly) != line)
+			s.video.tick(s.cpu, std::max(s.video.time_until_event(s.cpu), cputime(1)));
+	};
+	const auto finish_frame = [](system &s) {
+		run_frame(s.video, s.cpu);
+		s.video.sync();
+		const auto size = gb::video::width * 3;
+		std::vector<uint8_t> frame;
+		for (int y = save_line; y < gb::video::height; ++y)
+			frame.insert(frame.end(), s.video.frame().line(y), s.video.frame().line(y) + size);
+		return frame;
+	};
+
+	using f = gb::video::lcdc_flag;
+	for (auto *s : {&direct, &pipelined})
+	{
+		auto &cpu = s->cpu;
+		cpu.memory().write8(gb::video::r::lcdc, 0);
+		write_palette(cpu, gb::video::r::bgpi, {0x7FFF, 0x001F, 0x03E0, 0x7C00});
+		for (uint16_t i = 0; i < 0x800; ++i)
+			cpu.memory().write8(0x8000 + i, static_cast<uint8_t>(i * 7));
+		for (uint16_t i = 0; i < 0x800; ++i)
+			cpu.memory().write8(0x9800 + i, static_cast<uint8_t>(i / 3));
+		cpu.memory().write8(gb::video::r::wy, 20);
+		cpu.memory().write8(gb::video::r::wx, 50);
+		cpu.memory().write8(gb::video::r::lcdc, f::lcd_enable | f::window_tile_map_display_select
+			| f::window_display_enable | f::bg_window_data_select | f::bg_display);
+		run_frame(s->video, cpu);
+		run_to_line(*s, save_line);
+		gb::state_writer writer(s->state);
+		s->video.save_state(writer);
+		s->frame = finish_frame(*s);
+	}
+	BOOST_CHECK(direct.state == pipelined.state);
+	BOOST_CHECK(direct.frame == pipelined.frame);
+
+	for (auto *s : {&direct, &pipelined})
+	{
+		gb::state_reader reader(s->state);
+		s->video.load_state(reader);
+		BOOST_CHECK(reader.done());
+		BOOST_CHECK(finish_frame(*s) == direct.frame);
+	}
+	BOOST_CHECK(pipelined.video.pipelined());
+}
+
+BOOST_AUTO_TEST_CASE(test_video_time_until_event)
+{
+	gb::video video;
+	gb::internal_ram internal_ram;
+	gb::memory_map memory;
+	memory.add_mapping(&video);
+	memory.add_mapping(&internal_ram);
+	gb::z80_cpu cpu(std::move(memory), gb::register_file());
+	cpu.memory().write8(gb::video::r::lcdc, gb::video::lcdc_flag::lcd_enable);
+
+	auto mode = [&cpu]() { return cpu.memory().read8(gb::video::r::stat) & gb::video::stat_flag::mode; };
+	auto ly = [&cpu]() { return cpu.memory().read8(gb::video::r::ly); };
+	auto expect = [&](int expected_mode, int expected_ly) {
+		BOOST_REQUIRE_EQUAL(mode(), expected_mode);
+		BOOST_REQUIRE_EQUAL(ly(), expected_ly);
+	};
+	auto next_event = [&]() {
+		const auto until = video.time_until_event(cpu);
+		BOOST_REQUIRE_GT(until.count(), 0);
+		const int mode_before = mode(), ly_before = ly();
+		video.tick(cpu, until - cputime(1));
+		BOOST_REQUIRE_EQUAL(mode(), mode_before);
+		BOOST_REQUIRE_EQUAL(ly(), ly_before);
+		video.tick(cpu, cputime(1));
+		BOOST_REQUIRE(mode() != mode_before || ly() != ly_before);
+	};
+
+	// the LCD starts in the last vblank line
+	next_event();
+	for (int frame = 0; frame < 2; ++frame)
+	{
+		for (int line = 0; line < 144; ++line)
+		{
+			expect(gb::video::mode::read_oam, line);
+			next_event();
+			expect(gb::video::mode::read_vram, line);
+			next_event();
+			expect(gb::video::mode::hblank, line);
+			next_event();
+		}
+		// the end of every vblank line is an event of its own, LY is incremented at the end of
+		// each one but the last
+		for (int line = 143; line < 153; ++line)
+		{
+			expect(gb::video::mode::vblank, line);
+			next_event();
+		}
+	}
+	expect(gb::video::mode::read_oam, 0);
+	BOOST_CHECK_EQUAL(video.frames(), 2u);
+}
@@ -254,6 +254,46 @@ BOOST_AUTO_TEST_CASE(test_sbc8)
 	test_sbc8_impl(true, 0x00, 0xFF, true, true);
 }
 
+BOOST_AUTO_TEST_CASE(test_alu8_exhaustive)
+{
+	// add a,b; adc a,b; sub b; sbc a,b; cp b
+	const std::array<uint8_t, 5> ops{{0x80, 0x88, 0x90, 0x98, 0xB8}};
+	for (const auto op : ops)
+	{
+		test_memory mem({op});
+		const bool sub = op >= 0x90;
+		const bool uses_carry = op == 0x88 || op == 0x98;
+		for (int carry = 0; carry <= 1; ++carry)
+		{
+			for (int a = 0; a <= 0xFF; ++a)
+			{
+				for (int b = 0; b <= 0xFF; ++b)
+				{
+					gb::register_file registers;
+					registers.write8<gb::register8::a>(static_cast<uint8_t>(a));
+					registers.write8<gb::register8::b>(static_cast<uint8_t>(b));
+					registers.set<gb::cpu_flag::c>(carry != 0);
+					const auto cpu = run_cpu(&mem, 1, registers);
+
+					const int c = uses_carry ? carry : 0;
+					const int result = sub ? a - b - c : a + b + c;
+					const int half = sub ? (a & 0xF) - (b & 0xF) - c : (a & 0xF) + (b & 0xF) + c;
+					const auto &rs = cpu.registers();
+					if (rs.read8<gb::register8::a>() != (op == 0xB8 ? a : (result & 0xFF))
+						|| rs.get<gb::cpu_flag::z>() != ((result & 0xFF) == 0)
+						|| rs.get<gb::cpu_flag::n>() != sub
+						|| rs.get<gb::cpu_flag::h>() != (half < 0 || half > 0xF)
+						|| rs.get<gb::cpu_flag::c>() != (result < 0 || result > 0xFF))
+					{
+						BOOST_ERROR("wrong ALU result for opcode " << static_cast<int>(op)
+							<< " a=" << a << " b=" << b << " carry=" << carry);
+					}
+				}
+			}
+		}
+	}
+}
+
 BOOST_AUTO_TEST_CASE(test_daa)
 {
 	test_memory mem({0x27});
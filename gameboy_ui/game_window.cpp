@@ -6,7 +6,7 @@
 #include <z80opcodes.hpp>
 #include <debug.hpp>
 
-game_window::game_window(gb::rom rom, std::shared_ptr<const key_map> map, QWidget *parent) :
+game_window::game_window(gb::rom rom, const std::string &save_path, std::shared_ptr<const key_map> map, QWidget *parent) :
 	_keys(std::move(map)),
 	QMainWindow(parent)
 {
@@ -20,7 +20,8 @@ game_window::game_window(gb::rom rom, std::shared_ptr<const key_map> map, QWidge
 	connect(_refresh_timer, SIGNAL(timeout()), this, SLOT(update()));
 
 	_refresh_timer->start();
-	_thread.start(std::move(rom));
+	_thread.start(std::move(rom), save_path);
+	_thread.post_set_pixel_format(gb::pixel_format::rgba8888);
 }
 
 game_window::~game_window()
@@ -29,15 +30,15 @@ game_window::~game_window()
 
 void game_window::paintEvent(QPaintEvent *)
 {
-	auto image_future = _thread.post_get_image();
+	auto frame_future = _thread.post_get_frame();
 
 	QPainter painter(this);
 	painter.setBrush(Qt::black);
 	painter.setPen(Qt::black);
 	painter.drawRect(rect());
 
-	const auto image = image_future.get();
-	const QImage q_image(&image[0][0][0], gb::video::width, gb::video::height, QImage::Format_RGB888);
+	const auto frame = frame_future.get();
+	const QImage q_image(frame.data(), gb::video::width, gb::video::height, QImage::Format_RGBA8888);
 
 	const double aspect = static_cast<double>(gb::video::height) / gb::video::width;
 	const double real_aspect = static_cast<double>(height()) / width();
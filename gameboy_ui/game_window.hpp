@@ -16,8 +16,9 @@ public:
 	/**
 	 * The key_map has to life as long as this!
 	 * It will only be accessed from the Qt event loop.
+	 * Battery backed cartridge RAM is kept in save_path.
 	 */
-	game_window(gb::rom rom, std::shared_ptr<const key_map> map, QWidget *parent = 0);
+	game_window(gb::rom rom, const std::string &save_path, std::shared_ptr<const key_map> map, QWidget *parent = 0);
 	~game_window();
 
 protected:
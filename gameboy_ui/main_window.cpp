@@ -2,6 +2,7 @@
 #include "game_window.hpp"
 #include <rom.hpp>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QMessageBox>
 #include <QCloseEvent>
 #include <fstream>
@@ -64,7 +65,7 @@ void main_window::play()
 	{
 		try
 		{
-			_game_window = new game_window(*_rom, _key_map);
+			_game_window = new game_window(*_rom, _save_path, _key_map);
 			_game_window->setAttribute(Qt::WA_DeleteOnClose);
 			connect(_game_window, SIGNAL(destroyed()), this, SLOT(set_game_window_null()));
 			_game_window->show();
@@ -106,6 +107,8 @@ void main_window::load_rom(const std::string &path, bool show_error)
 	try
 	{
 		_rom = std::make_unique<gb::rom>(std::move(bytes));
+		const QFileInfo info(QString::fromStdString(path));
+		_save_path = (info.path() + "/" + info.completeBaseName() + ".sav").toStdString();
 	}
 	catch (gb::rom_error rom_error)
 	{
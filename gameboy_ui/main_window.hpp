@@ -31,6 +31,7 @@ private:
 	QSettings _settings;
 	Ui::mainWindowUiClass _ui;
 	std::unique_ptr<gb::rom> _rom;
+	std::string _save_path;
 	game_window *_game_window;
 	std::shared_ptr<game_window::key_map> _key_map;
 };
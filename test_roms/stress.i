@@ -0,0 +1,63 @@
+;------------------------------------------------------------------------------
+; common routines of the stress ROMs
+;
+; Every stress ROM runs a fixed workload which hammers one path of the emulator
+; and then writes the zero terminated marker "done" to STRESS_MARKER (high RAM)
+; and halts forever. A headless driver runs a ROM until the marker appears, so
+; the timings are reproducible and comparable between builds.
+;
+; Include this at the end of the code in bank 0.
+;------------------------------------------------------------------------------
+
+.DEFINE STRESS_MARKER $FF80
+
+; Clears the marker, call it first
+stress_start:
+	xor a
+	ld (STRESS_MARKER),a
+	ret
+
+; Writes the marker and hangs
+stress_done:
+	di
+	ld hl,stress_marker_text
+	ld de,STRESS_MARKER
+-	ldi a,(hl)
+	ld (de),a
+	inc de
+	cp $00
+	jr nz,-
+
+-	halt
+	jr -
+
+stress_marker_text: .DB "done" 0
+
+; Waits for the start of the next vblank (LY becomes 144), the LCD must be on
+wait_frame:
+-	ldh a,(R_LY)
+	cp 144
+	jr z,-
+-	ldh a,(R_LY)
+	cp 144
+	jr nz,-
+	ret
+
+; Turns the LCD off at the start of the next vblank
+lcd_off:
+	call wait_frame
+	xor a
+	ldh (R_LCDC),a
+	ret
+
+; hl = start address
+; bc = length
+; e = pattern
+fill_mem:
+-	ld a,e
+	ldi (hl),a
+	dec bc
+	ld a,b
+	or c
+	jr nz,-
+	ret
@@ -0,0 +1,73 @@
+.INCLUDE "cgb_hardware.i"
+
+.MEMORYMAP
+SLOTSIZE $4000
+DEFAULTSLOT 0
+SLOT 0 $0000
+SLOT 1 $4000
+.ENDME
+
+.ROMBANKMAP
+BANKSTOTAL 2
+BANKSIZE $4000
+BANKS 2
+.ENDRO
+
+.BANK 0 SLOT 0
+
+.CARTRIDGETYPE $00
+.COMPUTECHECKSUM
+.COMPUTEGBCOMPLEMENTCHECK
+.LICENSEECODENEW "  "
+.ORG $100
+	nop
+	jp entry
+.DB $CE $ED $66 $66 $CC $0D $00 $0B $03 $73 $00 $83 $00 $0C $00 $0D
+.DB $00 $08 $11 $1F $88 $89 $00 $0E $DC $CC $6E $E6 $DD $DD $D9 $99
+.DB $BB $BB $67 $63 $6E $0E $EC $CC $DD $DC $99 $9F $BB $B9 $33 $3E
+.BYTE "ALU"
+.ORG $13F
+.BYTE "STRS"
+.ORG $143
+.BYTE $C0
+
+; Tight 8 and 16 bit ALU loop, 4 * 65536 iterations
+
+.ORG $150
+entry: jp main
+
+main:
+	ld sp,$fffe
+	call stress_start
+
+	ld d,4
+	ld bc,0
+	ld e,$5A
+	ld hl,$1234
+alu_loop:
+	ld a,c
+	add e
+	adc b
+	sub l
+	sbc h
+	and $F7
+	or $21
+	xor e
+	cp b
+	inc a
+	dec e
+	ld e,a
+	daa
+	cpl
+	add hl,bc
+	inc hl
+	dec bc
+	ld a,b
+	or c
+	jr nz,alu_loop
+	dec d
+	jr nz,alu_loop
+
+	jp stress_done
+
+.INCLUDE "stress.i"
@@ -0,0 +1,78 @@
+.INCLUDE "cgb_hardware.i"
+
+.MEMORYMAP
+SLOTSIZE $4000
+DEFAULTSLOT 0
+SLOT 0 $0000
+SLOT 1 $4000
+.ENDME
+
+.ROMBANKMAP
+BANKSTOTAL 2
+BANKSIZE $4000
+BANKS 2
+.ENDRO
+
+.BANK 0 SLOT 0
+
+.CARTRIDGETYPE $00
+.COMPUTECHECKSUM
+.COMPUTEGBCOMPLEMENTCHECK
+.LICENSEECODENEW "  "
+.ORG $100
+	nop
+	jp entry
+.DB $CE $ED $66 $66 $CC $0D $00 $0B $03 $73 $00 $83 $00 $0C $00 $0D
+.DB $00 $08 $11 $1F $88 $89 $00 $0E $DC $CC $6E $E6 $DD $DD $D9 $99
+.DB $BB $BB $67 $63 $6E $0E $EC $CC $DD $DC $99 $9F $BB $B9 $33 $3E
+.BYTE "CB"
+.ORG $13F
+.BYTE "STRS"
+.ORG $143
+.BYTE $C0
+
+; CB prefixed rotations, shifts and bit operations on registers and (hl),
+; 2 * 65536 iterations
+
+.ORG $150
+entry: jp main
+
+main:
+	ld sp,$fffe
+	call stress_start
+
+	ld hl,$c000
+	ld (hl),$A5
+	ld d,2
+	ld bc,0
+	ld e,$3C
+	ld a,$81
+cb_loop:
+	rlc e
+	rrc a
+	rl e
+	rr a
+	sla e
+	sra a
+	swap e
+	srl a
+	bit 3,e
+	bit 7,a
+	set 5,e
+	res 2,a
+	rlc (hl)
+	swap (hl)
+	bit 1,(hl)
+	set 6,(hl)
+	res 6,(hl)
+	rr (hl)
+	dec bc
+	ld a,b
+	or c
+	jr nz,cb_loop
+	dec d
+	jr nz,cb_loop
+
+	jp stress_done
+
+.INCLUDE "stress.i"
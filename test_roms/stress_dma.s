@@ -0,0 +1,124 @@
+.INCLUDE "cgb_hardware.i"
+
+.MEMORYMAP
+SLOTSIZE $4000
+DEFAULTSLOT 0
+SLOT 0 $0000
+SLOT 1 $4000
+.ENDME
+
+.ROMBANKMAP
+BANKSTOTAL 2
+BANKSIZE $4000
+BANKS 2
+.ENDRO
+
+.BANK 0 SLOT 0
+
+; vblank
+.ORG $40
+	reti
+
+.CARTRIDGETYPE $00
+.COMPUTECHECKSUM
+.COMPUTEGBCOMPLEMENTCHECK
+.LICENSEECODENEW "  "
+.ORG $100
+	nop
+	jp entry
+.DB $CE $ED $66 $66 $CC $0D $00 $0B $03 $73 $00 $83 $00 $0C $00 $0D
+.DB $00 $08 $11 $1F $88 $89 $00 $0E $DC $CC $6E $E6 $DD $DD $D9 $99
+.DB $BB $BB $67 $63 $6E $0E $EC $CC $DD $DC $99 $9F $BB $B9 $33 $3E
+.BYTE "DMA"
+.ORG $13F
+.BYTE "STRS"
+.ORG $143
+.BYTE $C0
+
+; OAM DMA from a shadow OAM in WRAM at every vblank, the sprites move every
+; frame, 600 frames
+
+.DEFINE SHADOW_OAM $C000
+.DEFINE DMA_ROUTINE $FF90
+
+.ORG $150
+entry: jp main
+
+main:
+	ld sp,$fffe
+	call stress_start
+
+	; the DMA is started from high RAM
+	ld hl,dma_routine
+	ld c,DMA_ROUTINE & $FF
+	ld b,dma_routine_end - dma_routine
+-	ldi a,(hl)
+	ld ($FF00+c),a
+	inc c
+	dec b
+	jr nz,-
+
+	; 40 sprites, 4 rows of 10
+	ld hl,SHADOW_OAM
+	ld d,16            ; y
+--	ld e,8             ; x
+	ld b,10
+-	ld a,d
+	ldi (hl),a
+	ld a,e
+	ldi (hl),a
+	ld a,b
+	ldi (hl),a         ; tile
+	xor a
+	ldi (hl),a         ; attributes
+	ld a,e
+	add 16
+	ld e,a
+	dec b
+	jr nz,-
+	ld a,d
+	add 32
+	ld d,a
+	cp 16 + 4 * 32
+	jr nz,--
+
+	ld a,$01           ; vblank
+	ldh (R_IE),a
+	xor a
+	ldh (R_IF),a
+	ei
+
+	ld de,600
+frame_loop:
+	halt
+	nop
+	call DMA_ROUTINE
+
+	; move all sprites one pixel to the right
+	ld hl,SHADOW_OAM + 1
+	ld b,40
+-	inc (hl)
+	inc hl
+	inc hl
+	inc hl
+	inc hl
+	dec b
+	jr nz,-
+
+	dec de
+	ld a,d
+	or e
+	jr nz,frame_loop
+
+	jp stress_done
+
+dma_routine:
+	ld a,SHADOW_OAM >> 8
+	ldh (R_DMA),a
+	ld a,40
+-	dec a
+	jr nz,-
+	ret
+dma_routine_end:
+
+.INCLUDE "stress.i"
@@ -0,0 +1,72 @@
+.INCLUDE "cgb_hardware.i"
+
+.MEMORYMAP
+SLOTSIZE $4000
+DEFAULTSLOT 0
+SLOT 0 $0000
+SLOT 1 $4000
+.ENDME
+
+.ROMBANKMAP
+BANKSTOTAL 2
+BANKSIZE $4000
+BANKS 2
+.ENDRO
+
+.BANK 0 SLOT 0
+
+; vblank
+.ORG $40
+	reti
+; timer
+.ORG $50
+	reti
+
+.CARTRIDGETYPE $00
+.COMPUTECHECKSUM
+.COMPUTEGBCOMPLEMENTCHECK
+.LICENSEECODENEW "  "
+.ORG $100
+	nop
+	jp entry
+.DB $CE $ED $66 $66 $CC $0D $00 $0B $03 $73 $00 $83 $00 $0C $00 $0D
+.DB $00 $08 $11 $1F $88 $89 $00 $0E $DC $CC $6E $E6 $DD $DD $D9 $99
+.DB $BB $BB $67 $63 $6E $0E $EC $CC $DD $DC $99 $9F $BB $B9 $33 $3E
+.BYTE "HALT"
+.ORG $13F
+.BYTE "STRS"
+.ORG $143
+.BYTE $C0
+
+; Mostly halted CPU, woken up by the vblank and a slow timer interrupt,
+; 400 wake ups
+
+.ORG $150
+entry: jp main
+
+main:
+	ld sp,$fffe
+	call stress_start
+
+	xor a
+	ldh (R_TIMA),a
+	ldh (R_TMA),a
+	ld a,$04           ; 4096 Hz
+	ldh (R_TAC),a
+	ld a,$05           ; vblank and timer
+	ldh (R_IE),a
+	xor a
+	ldh (R_IF),a
+	ei
+
+	ld bc,400
+-	halt
+	nop
+	dec bc
+	ld a,b
+	or c
+	jr nz,-
+
+	jp stress_done
+
+.INCLUDE "stress.i"
@@ -0,0 +1,98 @@
+.INCLUDE "cgb_hardware.i"
+
+.MEMORYMAP
+SLOTSIZE $4000
+DEFAULTSLOT 0
+SLOT 0 $0000
+SLOT 1 $4000
+.ENDME
+
+.ROMBANKMAP
+BANKSTOTAL 2
+BANKSIZE $4000
+BANKS 2
+.ENDRO
+
+.BANK 0 SLOT 0
+
+; vblank
+.ORG $40
+	reti
+; STAT (hblank and LYC)
+.ORG $48
+	reti
+; timer
+.ORG $50
+	jp timer_interrupt
+
+.CARTRIDGETYPE $00
+.COMPUTECHECKSUM
+.COMPUTEGBCOMPLEMENTCHECK
+.LICENSEECODENEW "  "
+.ORG $100
+	nop
+	jp entry
+.DB $CE $ED $66 $66 $CC $0D $00 $0B $03 $73 $00 $83 $00 $0C $00 $0D
+.DB $00 $08 $11 $1F $88 $89 $00 $0E $DC $CC $6E $E6 $DD $DD $D9 $99
+.DB $BB $BB $67 $63 $6E $0E $EC $CC $DD $DC $99 $9F $BB $B9 $33 $3E
+.BYTE "IRQ"
+.ORG $13F
+.BYTE "STRS"
+.ORG $143
+.BYTE $C0
+
+; Interrupt storm: the timer overflows every 16 increments at 262144 Hz
+; (16384 interrupts per second) on top of hblank, LYC and vblank interrupts,
+; while the main loop does ALU work. Ends after $C000 timer interrupts.
+
+.DEFINE TIMER_COUNT $FF82  ; 16 bit
+
+.ORG $150
+entry: jp main
+
+main:
+	ld sp,$fffe
+	call stress_start
+
+	xor a
+	ld (TIMER_COUNT),a
+	ld (TIMER_COUNT + 1),a
+	ld a,$F0
+	ldh (R_TIMA),a
+	ldh (R_TMA),a
+	ld a,$05           ; 262144 Hz
+	ldh (R_TAC),a
+	ld a,72
+	ldh (R_LYC),a
+	ld a,$48           ; LYC and hblank interrupt
+	ldh (R_STAT),a
+	ld a,$07           ; vblank, STAT and timer
+	ldh (R_IE),a
+	xor a
+	ldh (R_IF),a
+	ei
+
+	ld bc,0
+-	ld a,b
+	add c
+	ld b,a
+	inc c
+	ld a,(TIMER_COUNT + 1)
+	cp $C0
+	jr c,-
+
+	jp stress_done
+
+timer_interrupt:
+	push af
+	push hl
+	ld hl,TIMER_COUNT
+	inc (hl)
+	jr nz,+
+	inc hl
+	inc (hl)
++	pop hl
+	pop af
+	reti
+
+.INCLUDE "stress.i"
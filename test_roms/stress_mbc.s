@@ -0,0 +1,102 @@
+.INCLUDE "cgb_hardware.i"
+
+.MEMORYMAP
+SLOTSIZE $4000
+DEFAULTSLOT 0
+SLOT 0 $0000
+SLOT 1 $4000
+.ENDME
+
+.ROMBANKMAP
+BANKSTOTAL 8
+BANKSIZE $4000
+BANKS 8
+.ENDRO
+
+.BANK 0 SLOT 0
+
+.CARTRIDGETYPE $19
+.ROMSIZE 2
+.RAMSIZE 0
+.COMPUTECHECKSUM
+.COMPUTEGBCOMPLEMENTCHECK
+.LICENSEECODENEW "  "
+.ORG $100
+	nop
+	jp entry
+.DB $CE $ED $66 $66 $CC $0D $00 $0B $03 $73 $00 $83 $00 $0C $00 $0D
+.DB $00 $08 $11 $1F $88 $89 $00 $0E $DC $CC $6E $E6 $DD $DD $D9 $99
+.DB $BB $BB $67 $63 $6E $0E $EC $CC $DD $DC $99 $9F $BB $B9 $33 $3E
+.BYTE "MBC"
+.ORG $13F
+.BYTE "STRS"
+.ORG $143
+.BYTE $C0
+
+; Code and data fetches from the switchable ROM bank with an MBC5 bank switch
+; before every call, 16384 iterations over the banks 1 to 7
+
+.DEFINE MBC5_ROM_BANK $2000
+
+.ORG $150
+entry: jp main
+
+main:
+	ld sp,$fffe
+	call stress_start
+
+	ld bc,$4000
+	ld e,1
+mbc_loop:
+	ld a,e
+	ld (MBC5_ROM_BANK),a
+	call $4000         ; sum of the bank's table in a
+	ld hl,$7FFF
+	add (hl)           ; and a data read at the end of the bank
+
+	inc e
+	ld a,e
+	cp 8
+	jr nz,+
+	ld e,1
++	dec bc
+	ld a,b
+	or c
+	jr nz,mbc_loop
+
+	jp stress_done
+
+.INCLUDE "stress.i"
+
+; Every bank has the same routine at $4000, which sums the 64 byte table at
+; $4040. The tables differ between the banks.
+.MACRO BANK_ROUTINE
+.ORG $0000
+	ld hl,$4040
+	xor a
+	ld b,64
+-	add (hl)
+	inc hl
+	dec b
+	jr nz,-
+	ret
+.ORG $0040
+.DSB 64 \1
+.ORG $3FFF
+.DB \1
+.ENDM
+
+.BANK 1 SLOT 1
+	BANK_ROUTINE 1
+.BANK 2 SLOT 1
+	BANK_ROUTINE 2
+.BANK 3 SLOT 1
+	BANK_ROUTINE 3
+.BANK 4 SLOT 1
+	BANK_ROUTINE 4
+.BANK 5 SLOT 1
+	BANK_ROUTINE 5
+.BANK 6 SLOT 1
+	BANK_ROUTINE 6
+.BANK 7 SLOT 1
+	BANK_ROUTINE 7
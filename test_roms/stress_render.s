@@ -0,0 +1,146 @@
+.INCLUDE "cgb_hardware.i"
+
+.MEMORYMAP
+SLOTSIZE $4000
+DEFAULTSLOT 0
+SLOT 0 $0000
+SLOT 1 $4000
+.ENDME
+
+.ROMBANKMAP
+BANKSTOTAL 2
+BANKSIZE $4000
+BANKS 2
+.ENDRO
+
+.BANK 0 SLOT 0
+
+; vblank
+.ORG $40
+	reti
+; STAT (hblank), scrolls every line
+.ORG $48
+	push af
+	ldh a,(R_SCX)
+	inc a
+	ldh (R_SCX),a
+	pop af
+	reti
+
+.CARTRIDGETYPE $00
+.COMPUTECHECKSUM
+.COMPUTEGBCOMPLEMENTCHECK
+.LICENSEECODENEW "  "
+.ORG $100
+	nop
+	jp entry
+.DB $CE $ED $66 $66 $CC $0D $00 $0B $03 $73 $00 $83 $00 $0C $00 $0D
+.DB $00 $08 $11 $1F $88 $89 $00 $0E $DC $CC $6E $E6 $DD $DD $D9 $99
+.DB $BB $BB $67 $63 $6E $0E $EC $CC $DD $DC $99 $9F $BB $B9 $33 $3E
+.BYTE "RENDER"
+.ORG $13F
+.BYTE "STRS"
+.ORG $143
+.BYTE $C0
+
+; Heavy rendering: 40 8x16 sprites with 10 on most lines, a different
+; background scroll on every line (hblank interrupt) and every frame,
+; 600 frames
+
+.ORG $150
+entry: jp main
+
+main:
+	ld sp,$fffe
+	call stress_start
+	call lcd_off
+
+	; tile data 8000-8FFF and both tile maps with a pattern
+	ld hl,$8000
+	ld bc,$1000
+	ld e,$5A
+	call fill_mem
+	ld hl,$9800
+	ld bc,$0800
+	ld e,$03
+	call fill_mem
+
+	; attributes (VRAM bank 1) of the map: palettes 0-7 and flips
+	ld a,1
+	ldh (R_VBK),a
+	ld hl,$9800
+	ld bc,$0800
+-	ld a,l
+	and $67
+	ldi (hl),a
+	dec bc
+	ld a,b
+	or c
+	jr nz,-
+	xor a
+	ldh (R_VBK),a
+
+	; background and sprite palettes with all colors
+	ld a,$80
+	ldh (R_BCPS),a
+	ldh (R_OCPS),a
+	ld b,64
+-	ld a,b
+	ldh (R_BCPD),a
+	cpl
+	ldh (R_OCPD),a
+	dec b
+	jr nz,-
+
+	; 40 sprites, 4 rows of 10, straight into OAM while the LCD is off
+	ld hl,$FE00
+	ld d,16            ; y
+--	ld e,8             ; x
+	ld b,10
+-	ld a,d
+	ldi (hl),a
+	ld a,e
+	ldi (hl),a
+	ld a,b
+	add a
+	ldi (hl),a         ; tile
+	ld a,b
+	and $67
+	ldi (hl),a         ; attributes: palette and flips
+	ld a,e
+	add 16
+	ld e,a
+	dec b
+	jr nz,-
+	ld a,d
+	add 36
+	ld d,a
+	cp 16 + 4 * 36
+	jr nz,--
+
+	; LCD on, tile data at 8000, 8x16 sprites, sprites and background on
+	ld a,$97
+	ldh (R_LCDC),a
+
+	ld a,$08           ; hblank interrupt
+	ldh (R_STAT),a
+	ld a,$03           ; vblank and STAT
+	ldh (R_IE),a
+	xor a
+	ldh (R_IF),a
+	ei
+
+	ld de,600
+frame_loop:
+	call wait_frame
+	ldh a,(R_SCY)
+	inc a
+	ldh (R_SCY),a
+	dec de
+	ld a,d
+	or e
+	jr nz,frame_loop
+
+	jp stress_done
+
+.INCLUDE "stress.i"
@@ -0,0 +1,68 @@
+.INCLUDE "cgb_hardware.i"
+
+.MEMORYMAP
+SLOTSIZE $4000
+DEFAULTSLOT 0
+SLOT 0 $0000
+SLOT 1 $4000
+.ENDME
+
+.ROMBANKMAP
+BANKSTOTAL 2
+BANKSIZE $4000
+BANKS 2
+.ENDRO
+
+.BANK 0 SLOT 0
+
+.CARTRIDGETYPE $00
+.COMPUTECHECKSUM
+.COMPUTEGBCOMPLEMENTCHECK
+.LICENSEECODENEW "  "
+.ORG $100
+	nop
+	jp entry
+.DB $CE $ED $66 $66 $CC $0D $00 $0B $03 $73 $00 $83 $00 $0C $00 $0D
+.DB $00 $08 $11 $1F $88 $89 $00 $0E $DC $CC $6E $E6 $DD $DD $D9 $99
+.DB $BB $BB $67 $63 $6E $0E $EC $CC $DD $DC $99 $9F $BB $B9 $33 $3E
+.BYTE "STAT"
+.ORG $13F
+.BYTE "STRS"
+.ORG $143
+.BYTE $C0
+
+; Busy polling of LY and the STAT mode, the CPU waits for every line and its
+; hblank for 300 frames
+
+.ORG $150
+entry: jp main
+
+main:
+	ld sp,$fffe
+	call stress_start
+
+	ld bc,300
+	call wait_frame
+frame_loop:
+	ld e,0
+line_loop:
+-	ldh a,(R_LY)
+	cp e
+	jr nz,-
+-	ldh a,(R_STAT)
+	and $03
+	jr nz,-            ; hblank
+	inc e
+	ld a,e
+	cp 144
+	jr nz,line_loop
+
+	call wait_frame
+	dec bc
+	ld a,b
+	or c
+	jr nz,frame_loop
+
+	jp stress_done
+
+.INCLUDE "stress.i"